@@ -5,6 +5,7 @@
 #include "wait.h"
 #include "timer.h"
 #include "debug.h"
+#include "debounce.h"
 
 #define CLK_HI() (PORTD |=  (1<<0))
 #define CLK_LO() (PORTD &= ~(1<<0))
@@ -15,7 +16,6 @@
 
 static matrix_row_t matrix[8] = {};
 static matrix_row_t matrix_debouncing[8] = {};
-static uint16_t debouncing_time = 0;
 
 
 void matrix_init(void)
@@ -33,12 +33,13 @@ void matrix_init(void)
     PORTD &= ~((1<<3) | (1<<0));    // low
     PORTD |=   (1<<2) | (1<<1);     // pull-up
 
+    debounce_init();
     dprintf("init\n");
 }
 
 uint8_t matrix_scan(void)
 {
-    // TODO: debouce & unplug detect
+    // TODO: unplug detect
     // Reset counters
     RST_HI();
     wait_us(10);
@@ -51,25 +52,19 @@ uint8_t matrix_scan(void)
             CLK_HI();
             wait_us(10);
 
-            // detect state change and start debounce
-            if ((matrix_debouncing[row] & (1<<col)) ^ (STATE()<<col)) {
-                matrix_debouncing[row] ^= (1<<col);
-                debouncing_time = timer_read() || 1;
+            if (STATE()) {
+                matrix_debouncing[row] |= (1<<col);
+            } else {
+                matrix_debouncing[row] &= ~(1<<col);
             }
-            
+
             // proceed counter - next row
             CLK_LO();
             wait_us(10);
         }
     }
 
-    // debounced
-    if (debouncing_time && timer_elapsed(debouncing_time) > DEBOUNCE) {
-        for (int row = 0; row < MATRIX_ROWS; row++) {
-            matrix[row] = matrix_debouncing[row];
-        }
-        debouncing_time = 0;
-    }
+    debounce(matrix_debouncing, matrix);
     return 1;
 }
 
@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "hid.h"
 #include "hidboot.h"
 #include "parser.h"
+#include "hid_keyboard.h"
+#include "usb_hid.h"
 
 #include "keycode.h"
 #include "util.h"
@@ -35,6 +37,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "keyboard.h"
 
+/* key changes are queued from USB callbacks in main loop, see matrix_scan() */
+#ifdef MATRIX_SCAN_ISR_ENABLE
+#   error "MATRIX_SCAN_ISR_ENABLE is not supported: USB Host Shield is polled in main loop"
+#endif
 
 /* KEY CODE to Matrix
  *
@@ -58,29 +64,203 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define CODE(row, col)  (((row) << 4) | (col))
 #define ROW(code)       (((code) & ROW_MASK) >> 4)
 #define COL(code)       ((code) & COL_MASK)
-#define ROW_BITS(code)  (1 << COL(code))
+#define ROW_BITS(code)  ((matrix_row_t)1 << COL(code))
 
 
-// Integrated key state of all keyboards
-static report_keyboard_t keyboard_report;
+// Integrated key state of all keyboards: bitmap of 256 keycodes
+static matrix_row_t matrix[MATRIX_ROWS];
+
+static bool matrix_is_mod = false;
 
-static bool matrix_is_mod =false;
 
 /*
- * USB Host Shield HID keyboards
- * This supports two cascaded hubs and four keyboards
+ * Key change events of keyboards
+ *
+ * Parsers put events while host Task() polls keyboards and matrix_scan()
+ * applies them to matrix in order. When the queue is full matrix is rebuilt
+ * from key state of parsers instead, then no key is left stuck.
+ *
+ * event: keyboard index(bit 9-15), pressed(bit 8), keycode(bit 0-7)
  */
+#ifndef USB_EVENT_QUEUE_SIZE
+#define USB_EVENT_QUEUE_SIZE    32
+#endif
+#if (USB_EVENT_QUEUE_SIZE & (USB_EVENT_QUEUE_SIZE - 1)) || (USB_EVENT_QUEUE_SIZE > 128)
+#   error "USB_EVENT_QUEUE_SIZE must be power of 2 and not exceed 128"
+#endif
+#define EVENT(kbd, code, pressed)   (((uint16_t)(kbd) << 9) | ((pressed) ? 0x100 : 0) | (code))
+#define EVENT_KBD(e)                ((e) >> 9)
+#define EVENT_PRESSED(e)            ((e) & 0x100)
+#define EVENT_CODE(e)               ((uint8_t)(e))
+
+static uint16_t event_queue[USB_EVENT_QUEUE_SIZE];
+static uint8_t event_head = 0;
+static uint8_t event_tail = 0;
+static bool event_overflow = false;
+
+
+/*
+ * USB Host Shield devices
+ * Hubs can be cascaded, keyboards are attached to root port or hubs.
+ */
+#ifndef USB_HUB_COUNT
+#define USB_HUB_COUNT   2
+#endif
+#ifndef USB_KBD_COUNT
+#define USB_KBD_COUNT   4
+#endif
+/* address 0 is reserved for device being enumerated */
+#if USB_HUB_COUNT + USB_KBD_COUNT >= USB_NUMDEVICES
+#   error "USB_HUB_COUNT + USB_KBD_COUNT must be less than USB_NUMDEVICES"
+#endif
+#if USB_KBD_COUNT > 127
+#   error "USB_KBD_COUNT must not exceed 127"
+#endif
+
+/* LED state of keyboard which is not set yet */
+#define LED_UNKNOWN     0xFF
+
 USB usb_host;
-USBHub hub1(&usb_host);
-USBHub hub2(&usb_host);
-HIDBoot<HID_PROTOCOL_KEYBOARD>    kbd1(&usb_host);
-HIDBoot<HID_PROTOCOL_KEYBOARD>    kbd2(&usb_host);
-HIDBoot<HID_PROTOCOL_KEYBOARD>    kbd3(&usb_host);
-HIDBoot<HID_PROTOCOL_KEYBOARD>    kbd4(&usb_host);
-KBDReportParser kbd_parser1;
-KBDReportParser kbd_parser2;
-KBDReportParser kbd_parser3;
-KBDReportParser kbd_parser4;
+
+class HubDevice : public USBHub
+{
+public:
+    HubDevice() : USBHub(&usb_host) {}
+};
+
+/* keyboard driver and its parser which puts key changes to event queue */
+class KBDDevice : public KBDReportParser
+{
+public:
+    HIDKeyboard hid;
+    uint8_t led;
+    KBDDevice() : hid(&usb_host, this), led(LED_UNKNOWN) {}
+protected:
+    virtual void KeyChange(uint8_t code, bool pressed);
+};
+
+static HubDevice hubs[USB_HUB_COUNT];
+static KBDDevice kbds[USB_KBD_COUNT];
+
+// LED state of host, set to keyboards in matrix_scan()
+static uint8_t led_state = 0;
+
+
+void KBDDevice::KeyChange(uint8_t code, bool pressed)
+{
+    uint8_t next = (event_head + 1) % USB_EVENT_QUEUE_SIZE;
+    if (next == event_tail) {
+        event_overflow = true;
+        return;
+    }
+    event_queue[event_head] = EVENT(this - kbds, code, pressed);
+    event_head = next;
+}
+
+/*
+ * applies queued events, returns whether matrix is changed
+ * Event of a key already changed in this scan is left for next scan, so
+ * that quick tap in one report interval is seen as press and release.
+ */
+static bool matrix_update(void)
+{
+    bool changed = false;
+    if (event_overflow) {
+        // events are lost, take key state of parsers and drop the rest
+        dprint("event queue overflow\n");
+        event_overflow = false;
+        event_tail = event_head;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            matrix_row_t bits = 0;
+            for (uint8_t i = 0; i < USB_KBD_COUNT; i++) {
+                bits |= kbds[i].keys[row * 2] | (kbds[i].keys[row * 2 + 1] << 8);
+            }
+            changed |= (matrix[row] != bits);
+            matrix[row] = bits;
+        }
+        return changed;
+    }
+
+    matrix_row_t touched[MATRIX_ROWS] = {};
+    while (event_tail != event_head) {
+        uint16_t e = event_queue[event_tail];
+        uint8_t code = EVENT_CODE(e);
+        if (touched[ROW(code)] & ROW_BITS(code)) break;
+        touched[ROW(code)] |= ROW_BITS(code);
+        event_tail = (event_tail + 1) % USB_EVENT_QUEUE_SIZE;
+        if (debug_matrix) dprintf("kbd%d: %02X %s\n", EVENT_KBD(e) + 1, code, EVENT_PRESSED(e) ? "d" : "u");
+
+        if (EVENT_PRESSED(e)) {
+            matrix[ROW(code)] |= ROW_BITS(code);
+        } else {
+            // key is still down on other keyboard
+            bool down = false;
+            for (uint8_t i = 0; i < USB_KBD_COUNT; i++) {
+                if (i != EVENT_KBD(e) && kbds[i].IsPressed(code)) down = true;
+            }
+            if (down) continue;
+            matrix[ROW(code)] &= ~ROW_BITS(code);
+        }
+        changed = true;
+    }
+
+    return changed;
+}
+
+
+/*
+ * Slice of work while host Task() is blocked
+ *
+ * Enumeration of a keyboard waits in delay() for seconds in total and it
+ * would stall other keyboards. In each millisecond of the wait keyboards
+ * ready are polled and keyboard_task() processes their events, with
+ * matrix_scan() which doesn't enter host Task() again.
+ */
+static bool in_task = false;
+static bool in_slice = false;
+
+extern "C" void yield(void)
+{
+    static uint16_t last = 0;
+    if (!in_task || in_slice || timer_read() == last) return;
+    in_slice = true;
+    last = timer_read();
+
+    for (uint8_t i = 0; i < USB_KBD_COUNT; i++) {
+        if (kbds[i].hid.isReady()) kbds[i].hid.Poll();
+    }
+    keyboard_task();
+
+    in_slice = false;
+}
+
+
+/*
+ * Sets LED state to a keyboard whose state differs, one per scan so that
+ * blocking SetReport doesn't stall the loop for every keyboard at once.
+ * State of keyboard is unknown until it is ready, then it is set when
+ * attached to hub as well as root port.
+ */
+static void led_update(void)
+{
+    static uint8_t next = 0;
+    for (uint8_t n = 0; n < USB_KBD_COUNT; n++) {
+        KBDDevice *kbd = &kbds[next];
+        uint8_t i = next;
+        next = (next + 1) % USB_KBD_COUNT;
+        if (!kbd->hid.isReady()) {
+            kbd->led = LED_UNKNOWN;
+            continue;
+        }
+        if (kbd->led == led_state) continue;
+
+        uint8_t rcode = kbd->hid.SetLed(led_state);
+        if (rcode) dprintf("LED kbd%d: failed(%02X)\n", i + 1, rcode);
+        // not retried as some keyboards stall LED report
+        kbd->led = led_state;
+        return;
+    }
+}
 
 
 uint8_t matrix_rows(void) { return MATRIX_ROWS; }
@@ -89,79 +269,33 @@ bool matrix_has_ghost(void) { return false; }
 void matrix_init(void) {
     // USB Host Shield setup
     usb_host.Init();
-    kbd1.SetReportParser(0, (HIDReportParser*)&kbd_parser1);
-    kbd2.SetReportParser(0, (HIDReportParser*)&kbd_parser2);
-    kbd3.SetReportParser(0, (HIDReportParser*)&kbd_parser3);
-    kbd4.SetReportParser(0, (HIDReportParser*)&kbd_parser4);
-}
-
-static void or_report(report_keyboard_t report) {
-    // integrate reports into keyboard_report
-    keyboard_report.mods |= report.mods;
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (IS_ANY(report.keys[i])) {
-            for (uint8_t j = 0; j < KEYBOARD_REPORT_KEYS; j++) {
-                if (! keyboard_report.keys[j]) {
-                    keyboard_report.keys[j] = report.keys[i];
-                    break;
-                }
-            }
-        }
-    }
 }
 
 uint8_t matrix_scan(void) {
-    static uint16_t last_time_stamp1 = 0;
-    static uint16_t last_time_stamp2 = 0;
-    static uint16_t last_time_stamp3 = 0;
-    static uint16_t last_time_stamp4 = 0;
-
-    // check report came from keyboards
-    if (kbd_parser1.time_stamp != last_time_stamp1 ||
-        kbd_parser2.time_stamp != last_time_stamp2 ||
-        kbd_parser3.time_stamp != last_time_stamp3 ||
-        kbd_parser4.time_stamp != last_time_stamp4) {
-
-        last_time_stamp1 = kbd_parser1.time_stamp;
-        last_time_stamp2 = kbd_parser2.time_stamp;
-        last_time_stamp3 = kbd_parser3.time_stamp;
-        last_time_stamp4 = kbd_parser4.time_stamp;
-
-        // clear and integrate all reports
-        keyboard_report = {};
-        or_report(kbd_parser1.report);
-        or_report(kbd_parser2.report);
-        or_report(kbd_parser3.report);
-        or_report(kbd_parser4.report);
-
-        matrix_is_mod = true;
-
-        dprintf("state:  %02X %02X", keyboard_report.mods, keyboard_report.reserved);
-        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-            dprintf(" %02X", keyboard_report.keys[i]);
-        }
-        dprint("\r\n");
-    } else {
-        matrix_is_mod = false;
+    // called in slice, keyboards are polled there
+    if (in_task) {
+        matrix_is_mod = matrix_update();
+        return 1;
     }
 
     uint16_t timer;
     timer = timer_read();
+    in_task = true;
     usb_host.Task();
+    in_task = false;
     timer = timer_elapsed(timer);
     if (timer > 100) {
         dprintf("host.Task: %d\n", timer);
     }
+    matrix_is_mod = matrix_update();
+    led_update();
 
     static uint8_t usb_state = 0;
     if (usb_state != usb_host.getUsbTaskState()) {
         usb_state = usb_host.getUsbTaskState();
         dprintf("usb_state: %02X\n", usb_state);
-
-        // restore LED state when keyboard comes up
         if (usb_state == USB_STATE_RUNNING) {
             dprintf("speed: %s\n", usb_host.getVbusState()==FSHOST ? "full" : "low");
-            keyboard_set_leds(host_keyboard_leds());
         }
     }
     return 1;
@@ -172,46 +306,17 @@ bool matrix_is_modified(void) {
 }
 
 bool matrix_is_on(uint8_t row, uint8_t col) {
-    uint8_t code = CODE(row, col);
-
-    if (IS_MOD(code)) {
-        if (keyboard_report.mods & ROW_BITS(code)) {
-            return true;
-        }
-    }
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (keyboard_report.keys[i] == code) {
-            return true;
-        }
-    }
-    return false;
+    return (matrix[row] & ((matrix_row_t)1<<col));
 }
 
 matrix_row_t matrix_get_row(uint8_t row) {
-    uint16_t row_bits = 0;
-
-    if (IS_MOD(CODE(row, 0)) && keyboard_report.mods) {
-        row_bits |= keyboard_report.mods;
-    }
-
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (IS_ANY(keyboard_report.keys[i])) {
-            if (row == ROW(keyboard_report.keys[i])) {
-                row_bits |= ROW_BITS(keyboard_report.keys[i]);
-            }
-        }
-    }
-    return row_bits;
+    return matrix[row];
 }
 
 uint8_t matrix_key_count(void) {
     uint8_t count = 0;
-
-    count += bitpop(keyboard_report.mods);
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (IS_ANY(keyboard_report.keys[i])) {
-            count++;
-        }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        count += bitpop16(matrix[row]);
     }
     return count;
 }
@@ -227,8 +332,5 @@ void matrix_print(void) {
 
 void led_set(uint8_t usb_led)
 {
-    kbd1.SetReport(0, 0, 2, 0, 1, &usb_led);
-    kbd2.SetReport(0, 0, 2, 0, 1, &usb_led);
-    kbd3.SetReport(0, 0, 2, 0, 1, &usb_led);
-    kbd4.SetReport(0, 0, 2, 0, 1, &usb_led);
+    led_state = usb_led;
 }
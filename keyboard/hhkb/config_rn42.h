@@ -53,6 +53,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /* power control of key switch board */
 #define HHKB_POWER_SAVING
 
+/* scan every 10ms after 5s of idle matrix on battery */
+#define MATRIX_SCAN_IDLE_TIMEOUT    5000
+#define MATRIX_SCAN_IDLE_INTERVAL   10
+
 /*
  * Hardware Serial(UART)
  *     Baud rate are calculated with round off(+0.5).
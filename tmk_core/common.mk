@@ -1,12 +1,15 @@
 COMMON_DIR = common
 SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/keyboard.c \
+	$(COMMON_DIR)/keyevent_queue.c \
 	$(COMMON_DIR)/matrix.c \
+	$(COMMON_DIR)/debounce.c \
 	$(COMMON_DIR)/action.c \
 	$(COMMON_DIR)/action_tapping.c \
 	$(COMMON_DIR)/action_macro.c \
 	$(COMMON_DIR)/action_layer.c \
 	$(COMMON_DIR)/action_util.c \
+	$(COMMON_DIR)/report.c \
 	$(COMMON_DIR)/print.c \
 	$(COMMON_DIR)/debug.c \
 	$(COMMON_DIR)/util.c \
@@ -82,6 +85,43 @@ ifeq (yes,$(strip $(BACKLIGHT_ENABLE)))
     OPT_DEFS += -DBACKLIGHT_ENABLE
 endif
 
+ifeq (yes,$(strip $(MATRIX_SCAN_ISR_ENABLE)))
+    OPT_DEFS += -DMATRIX_SCAN_ISR_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYBOARD_PROFILE_ENABLE)))
+    SRC += $(COMMON_DIR)/keyboard_profile.c
+    OPT_DEFS += -DKEYBOARD_PROFILE_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYBOARD_RECORD_ENABLE)))
+    SRC += $(COMMON_DIR)/keyboard_record.c
+    OPT_DEFS += -DKEYBOARD_RECORD_ENABLE
+endif
+
+ifeq (yes,$(strip $(LAYER_CACHE_ENABLE)))
+    OPT_DEFS += -DLAYER_CACHE_ENABLE
+endif
+
+ifeq (yes,$(strip $(LAYER_MASK_ENABLE)))
+    ifeq (yes,$(strip $(KEYMAP_SECTION_ENABLE)))
+        $(error LAYER_MASK_ENABLE: mask is not updated with keymap section for editor)
+    endif
+    OPT_DEFS += -DLAYER_MASK_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYMAP_COMPILE_ENABLE)))
+    ifeq (yes,$(strip $(KEYMAP_SECTION_ENABLE)))
+        $(error KEYMAP_COMPILE_ENABLE: keymap section for editor is not flattened)
+    endif
+    SRC += $(COMMON_DIR)/keymap_flat.c
+    OPT_DEFS += -DKEYMAP_COMPILE_ENABLE
+endif
+
+ifneq (,$(filter yes,$(strip $(LAYER_MASK_ENABLE)) $(strip $(KEYMAP_COMPILE_ENABLE))))
+    include $(TMK_DIR)/tool/keymap_compile/keymap_compile.mk
+endif
+
 ifeq (yes,$(strip $(KEYMAP_SECTION_ENABLE)))
     OPT_DEFS += -DKEYMAP_SECTION_ENABLE
 
@@ -56,6 +56,15 @@ void action_exec(keyevent_t event)
 #endif
 }
 
+bool action_ready(void)
+{
+#ifndef NO_ACTION_TAPPING
+    return action_tapping_ready();
+#else
+    return true;
+#endif
+}
+
 void process_action(keyrecord_t *record)
 {
     keyevent_t event = record->event;
@@ -48,6 +48,8 @@ typedef struct {
 
 /* Execute action per keyevent */
 void action_exec(keyevent_t event);
+/* whether action_exec() can take a key event now, otherwise caller should hold it */
+bool action_ready(void);
 
 /* action for key */
 action_t action_for_key(uint8_t layer, keypos_t key);
@@ -1,9 +1,12 @@
 #include <stdint.h>
+#include <string.h>
 #include "keyboard.h"
+#include "matrix.h"
 #include "action.h"
 #include "util.h"
 #include "action_layer.h"
 #include "hook.h"
+#include "progmem.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -12,6 +15,27 @@
 #endif
 
 
+#ifdef LAYER_MASK_ENABLE
+/* layers which have non-transparent action on each key, generated by
+ * tool/keymap_compile at build */
+extern const uint32_t layer_mask[MATRIX_ROWS][MATRIX_COLS];
+#endif
+
+#ifdef LAYER_CACHE_ENABLE
+/*
+ * Action and layer resolved for each key with current layer state, valid
+ * until layer_state or default_layer_state changes.
+ */
+static matrix_row_t cache_valid[MATRIX_ROWS];
+static uint8_t cache_layer[MATRIX_ROWS][MATRIX_COLS];
+static action_t cache_action[MATRIX_ROWS][MATRIX_COLS];
+
+void layer_cache_clear(void)
+{
+    memset(cache_valid, 0, sizeof(cache_valid));
+}
+#endif
+
 /* 
  * Default Layer State
  */
@@ -21,6 +45,7 @@ static void default_layer_state_set(uint32_t state)
 {
     debug("default_layer_state: ");
     default_layer_debug(); debug(" to ");
+    if (default_layer_state != state) layer_cache_clear();
     default_layer_state = state;
     hook_default_layer_change(default_layer_state);
     default_layer_debug(); debug("\n");
@@ -65,6 +90,7 @@ static void layer_state_set(uint32_t state)
 {
     dprint("layer_state: ");
     layer_debug(); dprint(" to ");
+    if (layer_state != state) layer_cache_clear();
     layer_state = state;
     hook_layer_change(layer_state);
     layer_debug(); dprintln();
@@ -119,26 +145,51 @@ void layer_debug(void)
 
 
 
-/* return layer effective for key at this time */
-static uint8_t current_layer_for_key(keypos_t key)
+/* return action of key and layer effective for it at this time */
+static action_t current_action_for_key(keypos_t key, uint8_t *layer)
 {
-#ifndef NO_ACTION_LAYER
-    action_t action = ACTION_TRANSPARENT;
+    action_t action;
+#ifdef LAYER_CACHE_ENABLE
+    matrix_row_t bit = (matrix_row_t)1<<key.col;
+    if (cache_valid[key.row] & bit) {
+        *layer = cache_layer[key.row][key.col];
+        return cache_action[key.row][key.col];
+    }
+#endif
+
+#if !defined(NO_ACTION_LAYER) && defined(LAYER_MASK_ENABLE)
+    /* top layer which is on and not transparent, or fall back to layer 0 */
+    uint32_t layers = (layer_state | default_layer_state) &
+                      pgm_read_dword(&layer_mask[key.row][key.col]);
+    *layer = layers ? biton32(layers) : 0;
+#elif !defined(NO_ACTION_LAYER)
     uint32_t layers = layer_state | default_layer_state;
     /* check top layer first */
     for (int8_t i = 31; i >= 0; i--) {
         if (layers & (1UL<<i)) {
             action = action_for_key(i, key);
             if (action.code != (action_t)ACTION_TRANSPARENT.code) {
-                return i;
+                *layer = i;
+                goto FOUND;
             }
         }
     }
     /* fall back to layer 0 */
-    return 0;
+    *layer = 0;
 #else
-    return biton32(default_layer_state);
+    *layer = biton32(default_layer_state);
+#endif
+    action = action_for_key(*layer, key);
+
+#if !defined(NO_ACTION_LAYER) && !defined(LAYER_MASK_ENABLE)
+FOUND:
+#endif
+#ifdef LAYER_CACHE_ENABLE
+    cache_layer[key.row][key.col] = *layer;
+    cache_action[key.row][key.col] = action;
+    cache_valid[key.row] |= bit;
 #endif
+    return action;
 }
 
 
@@ -151,13 +202,21 @@ action_t layer_switch_get_action(keyevent_t event)
     uint8_t layer = 0;
 #ifndef NO_TRACK_KEY_PRESS
     if (event.pressed) {
-        layer = current_layer_for_key(event.key);
+        action_t action = current_action_for_key(event.key, &layer);
         layer_pressed[event.key.row][event.key.col] = layer;
-    } else {
-        layer = layer_pressed[event.key.row][event.key.col];
+        return action;
+    }
+
+    layer = layer_pressed[event.key.row][event.key.col];
+#ifdef LAYER_CACHE_ENABLE
+    // released on the layer state it was pressed
+    if ((cache_valid[event.key.row] & ((matrix_row_t)1<<event.key.col)) &&
+            cache_layer[event.key.row][event.key.col] == layer) {
+        return cache_action[event.key.row][event.key.col];
     }
-#else
-    layer = current_layer_for_key(event.key);
 #endif
     return action_for_key(layer, event.key);
+#else
+    return current_action_for_key(event.key, &layer);
+#endif
 }
@@ -58,4 +58,12 @@ void layer_xor(uint32_t state);
 /* return action depending on current layer status */
 action_t layer_switch_get_action(keyevent_t key);
 
+/* Resolved actions are cached per key with LAYER_CACHE_ENABLE. Call this
+ * when keymap itself is changed at runtime. */
+#ifdef LAYER_CACHE_ENABLE
+void layer_cache_clear(void);
+#else
+#define layer_cache_clear()
+#endif
+
 #endif
@@ -1,10 +1,12 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "action.h"
 #include "action_layer.h"
 #include "action_tapping.h"
 #include "keycode.h"
 #include "timer.h"
+#include "matrix.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -18,17 +20,38 @@
 #define IS_TAPPING_PRESSED()    (IS_TAPPING() && tapping_key.event.pressed)
 #define IS_TAPPING_RELEASED()   (IS_TAPPING() && !tapping_key.event.pressed)
 #define IS_TAPPING_KEY(k)       (IS_TAPPING() && KEYEQ(tapping_key.event.key, (k)))
-#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
+#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < tapping_term)
+
+
+#define WAITING_BUFFER_NEXT(i)  (((i) + 1) & (WAITING_BUFFER_SIZE - 1))
+#define WAITING_BUFFER_FULL()   (WAITING_BUFFER_NEXT(waiting_buffer_head) == waiting_buffer_tail)
+#define WAITING_NONE            WAITING_BUFFER_SIZE
 
 
 static keyrecord_t tapping_key = {};
+/* tapping term of tapping_key */
+static uint16_t tapping_term = TAPPING_TERM;
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
 static uint8_t waiting_buffer_head = 0;
 static uint8_t waiting_buffer_tail = 0;
 
+/* Index of keys in waiting_buffer
+ * Bit of key is set while its press or release event is in the buffer.
+ * waiting_dups counts events enqueued when the bit was already set, only
+ * then the buffer is scanned to update the bit on dequeue.
+ */
+static matrix_row_t waiting_pressed[MATRIX_ROWS];
+static matrix_row_t waiting_released[MATRIX_ROWS];
+static uint8_t waiting_dups = 0;
+
 static bool process_tapping(keyrecord_t *record);
+static void tapping_start(keyrecord_t *keyp);
 static bool waiting_buffer_enq(keyrecord_t record);
+static void waiting_buffer_deq(void);
 static void waiting_buffer_clear(void);
+static uint8_t waiting_buffer_find(keypos_t key, bool pressed);
+static bool waiting_buffer_has(keypos_t key, bool pressed);
+static void waiting_buffer_settle(void);
 static bool waiting_buffer_typed(keyevent_t event);
 static void waiting_buffer_scan_tap(void);
 static void debug_tapping_key(void);
@@ -43,11 +66,10 @@ void action_tapping_process(keyrecord_t record)
         }
     } else {
         if (!waiting_buffer_enq(record)) {
-            // clear all in case of overflow.
-            debug("OVERFLOW: CLEAR ALL STATES\n");
-            clear_keyboard();
-            waiting_buffer_clear();
-            tapping_key = (keyrecord_t){};
+            // caller didn't check action_tapping_ready()
+            debug("OVERFLOW: SETTLE TAPPING\n");
+            waiting_buffer_settle();
+            process_action(&record);
         }
     }
 
@@ -55,10 +77,11 @@ void action_tapping_process(keyrecord_t record)
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
-    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
+    while (waiting_buffer_tail != waiting_buffer_head) {
         if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
             debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
             debug_record(waiting_buffer[waiting_buffer_tail]); debug("\n\n");
+            waiting_buffer_deq();
         } else {
             break;
         }
@@ -68,10 +91,32 @@ void action_tapping_process(keyrecord_t record)
     }
 }
 
+bool action_tapping_ready(void)
+{
+    return !WAITING_BUFFER_FULL();
+}
+
+
+/* tapping term of tap key, keymap can override this to give each key or action its own term */
+__attribute__ ((weak))
+uint16_t action_get_tapping_term(keyrecord_t *record, action_t action)
+{
+    (void)record;
+    (void)action;
+    return TAPPING_TERM;
+}
+
+/* start tapping with new tap key */
+static void tapping_start(keyrecord_t *keyp)
+{
+    tapping_key = *keyp;
+    tapping_term = action_get_tapping_term(keyp, layer_switch_get_action(keyp->event));
+}
+
 
 /* Tapping
  *
- * Rule: Tap key is typed(pressed and released) within TAPPING_TERM.
+ * Rule: Tap key is typed(pressed and released) within its tapping term.
  *       (without interfering by typing other key)
  */
 /* return true when key event is processed or consumed. */
@@ -95,10 +140,12 @@ bool process_tapping(keyrecord_t *keyp)
                     // enqueue
                     return false;
                 }
-#if TAPPING_TERM >= 500
+#if TAPPING_TERM >= 500 || defined(PERMISSIVE_HOLD)
                 /* Process a key typed within TAPPING_TERM
                  * This can register the key before settlement of tapping,
                  * useful for long TAPPING_TERM but may prevent fast typing.
+                 * PERMISSIVE_HOLD: hold is settled as soon as other key is
+                 * pressed and released, without waiting for the term.
                  */
                 else if (IS_RELEASED(event) && waiting_buffer_typed(event)) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
@@ -165,7 +212,7 @@ bool process_tapping(keyrecord_t *keyp)
                     } else {
                         debug("Tapping: Start while last tap(1).\n");
                     }
-                    tapping_key = *keyp;
+                    tapping_start(keyp);
                     waiting_buffer_scan_tap();
                     debug_tapping_key();
                     return true;
@@ -209,7 +256,7 @@ bool process_tapping(keyrecord_t *keyp)
                     } else {
                         debug("Tapping: Start while last timeout tap(1).\n");
                     }
-                    tapping_key = *keyp;
+                    tapping_start(keyp);
                     waiting_buffer_scan_tap();
                     debug_tapping_key();
                     return true;
@@ -244,7 +291,7 @@ bool process_tapping(keyrecord_t *keyp)
                 } else if (is_tap_key(event)) {
                     // Sequential tap can be interfered with other tap key.
                     debug("Tapping: Start with interfering other tap.\n");
-                    tapping_key = *keyp;
+                    tapping_start(keyp);
                     waiting_buffer_scan_tap();
                     debug_tapping_key();
                     return true;
@@ -274,7 +321,7 @@ bool process_tapping(keyrecord_t *keyp)
     else {
         if (event.pressed && is_tap_key(event)) {
             debug("Tapping: Start(Press tap key).\n");
-            tapping_key = *keyp;
+            tapping_start(keyp);
             waiting_buffer_scan_tap();
             debug_tapping_key();
             return true;
@@ -295,32 +342,92 @@ bool waiting_buffer_enq(keyrecord_t record)
         return true;
     }
 
-    if ((waiting_buffer_head + 1) % WAITING_BUFFER_SIZE == waiting_buffer_tail) {
+    if (WAITING_BUFFER_FULL()) {
         debug("waiting_buffer_enq: Over flow.\n");
         return false;
     }
 
+    keyevent_t event = record.event;
+    if (event.key.row < MATRIX_ROWS) {
+        matrix_row_t *index = event.pressed ? &waiting_pressed[event.key.row] : &waiting_released[event.key.row];
+        if (*index & ((matrix_row_t)1<<event.key.col)) {
+            waiting_dups++;
+        } else {
+            *index |= ((matrix_row_t)1<<event.key.col);
+        }
+    }
+
     waiting_buffer[waiting_buffer_head] = record;
-    waiting_buffer_head = (waiting_buffer_head + 1) % WAITING_BUFFER_SIZE;
+    waiting_buffer_head = WAITING_BUFFER_NEXT(waiting_buffer_head);
 
     debug("waiting_buffer_enq: "); debug_waiting_buffer();
     return true;
 }
 
+void waiting_buffer_deq(void)
+{
+    keyevent_t event = waiting_buffer[waiting_buffer_tail].event;
+    waiting_buffer_tail = WAITING_BUFFER_NEXT(waiting_buffer_tail);
+
+    if (event.key.row >= MATRIX_ROWS) return;
+    // the key has another same event still in buffer
+    if (waiting_dups && waiting_buffer_find(event.key, event.pressed) != WAITING_NONE) {
+        waiting_dups--;
+        return;
+    }
+    matrix_row_t *index = event.pressed ? &waiting_pressed[event.key.row] : &waiting_released[event.key.row];
+    *index &= ~((matrix_row_t)1<<event.key.col);
+}
+
 void waiting_buffer_clear(void)
 {
     waiting_buffer_head = 0;
     waiting_buffer_tail = 0;
+    memset(waiting_pressed, 0, sizeof(waiting_pressed));
+    memset(waiting_released, 0, sizeof(waiting_released));
+    waiting_dups = 0;
 }
 
-bool waiting_buffer_typed(keyevent_t event)
+/* position of first event of the key in buffer, or WAITING_NONE */
+uint8_t waiting_buffer_find(keypos_t key, bool pressed)
 {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (KEYEQ(event.key, waiting_buffer[i].event.key) && event.pressed !=  waiting_buffer[i].event.pressed) {
-            return true;
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
+        if (KEYEQ(key, waiting_buffer[i].event.key) && pressed == waiting_buffer[i].event.pressed) {
+            return i;
         }
     }
-    return false;
+    return WAITING_NONE;
+}
+
+bool waiting_buffer_has(keypos_t key, bool pressed)
+{
+    if (key.row >= MATRIX_ROWS) {
+        // not indexed
+        return waiting_buffer_find(key, pressed) != WAITING_NONE;
+    }
+    matrix_row_t index = pressed ? waiting_pressed[key.row] : waiting_released[key.row];
+    return index & ((matrix_row_t)1<<key.col);
+}
+
+/* whether the key is typed in buffer, its opposite event is there */
+bool waiting_buffer_typed(keyevent_t event)
+{
+    return waiting_buffer_has(event.key, !event.pressed);
+}
+
+/* settle tapping key as hold and process all events in buffer as is */
+void waiting_buffer_settle(void)
+{
+    if (IS_TAPPING_PRESSED() && tapping_key.tap.count == 0) {
+        process_action(&tapping_key);
+    }
+    tapping_key = (keyrecord_t){};
+    debug_tapping_key();
+    while (waiting_buffer_tail != waiting_buffer_head) {
+        process_action(&waiting_buffer[waiting_buffer_tail]);
+        waiting_buffer_tail = WAITING_BUFFER_NEXT(waiting_buffer_tail);
+    }
+    waiting_buffer_clear();
 }
 
 /* scan buffer for tapping */
@@ -330,8 +437,10 @@ void waiting_buffer_scan_tap(void)
     if (tapping_key.tap.count > 0) return;
     // invalid state: tapping_key released && tap.count == 0
     if (!tapping_key.event.pressed) return;
+    // release of tapping key is not in buffer
+    if (!waiting_buffer_has(tapping_key.event.key, false)) return;
 
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
         if (IS_TAPPING_KEY(waiting_buffer[i].event.key) &&
                 !waiting_buffer[i].event.pressed &&
                 WITHIN_TAPPING_TERM(waiting_buffer[i].event)) {
@@ -358,7 +467,7 @@ static void debug_tapping_key(void)
 static void debug_waiting_buffer(void)
 {
     debug("{ ");
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = WAITING_BUFFER_NEXT(i)) {
         debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer[i]); debug(" ");
     }
     debug("}\n");
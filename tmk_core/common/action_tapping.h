@@ -29,11 +29,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define TAPPING_TOGGLE  5
 #endif
 
+/* key events held while tapping is not settled, must be power of 2 */
+#ifndef WAITING_BUFFER_SIZE
 #define WAITING_BUFFER_SIZE 8
+#endif
+
+#if (WAITING_BUFFER_SIZE & (WAITING_BUFFER_SIZE - 1)) || (WAITING_BUFFER_SIZE > 128)
+#   error "WAITING_BUFFER_SIZE must be power of 2 and not exceed 128"
+#endif
 
 
 #ifndef NO_ACTION_TAPPING
 void action_tapping_process(keyrecord_t record);
+/* tapping term(ms) of tap key, TAPPING_TERM by default */
+uint16_t action_get_tapping_term(keyrecord_t *record, action_t action);
+/* whether next key event can be taken; false while waiting_buffer is full */
+bool action_tapping_ready(void);
 #endif
 
 #endif
@@ -14,30 +14,39 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <string.h>
 #include "host.h"
 #include "report.h"
 #include "debug.h"
+#include "util.h"
 #include "action_util.h"
 #include "timer.h"
 
-static inline void add_key_byte(uint8_t code);
-static inline void del_key_byte(uint8_t code);
-#ifdef NKRO_ENABLE
-static inline void add_key_bit(uint8_t code);
-static inline void del_key_bit(uint8_t code);
-#endif
-
 static uint8_t real_mods = 0;
 static uint8_t weak_mods = 0;
 
+/*
+ * Key state is kept in bitmap of 256 keycodes with count of keys on, and
+ * the report is rendered from it only when sent. Adding and deleting key
+ * take constant time and no key is lost by report size or by switching
+ * between boot and NKRO protocol.
+ */
+static uint8_t key_bits[32];
+static uint8_t key_count = 0;
+
+/* boot protocol report carries 6 keys even when report is extended for NKRO */
+#define BOOT_REPORT_KEYS    6
+
+#ifdef NKRO_ENABLE
+/* protocol which keyboard_report was rendered last with */
+static bool report_nkro = false;
+#endif
+
 #ifdef USB_6KRO_ENABLE
-#define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
-#define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
-#define RO_INC(a) RO_ADD(a, 1)
-#define RO_DEC(a) RO_SUB(a, 1)
-static int8_t cb_head = 0;
-static int8_t cb_tail = 0;
-static int8_t cb_count = 0;
+/* recently pressed keys, newest at recent_head - 1, so that rolling 6KRO
+ * reports newest keys */
+static uint8_t recent[BOOT_REPORT_KEYS];
+static uint8_t recent_head = 0;
 #endif
 
 // TODO: pointer variable is not needed
@@ -52,7 +61,100 @@ static int16_t oneshot_time = 0;
 #endif
 
 
+static inline bool is_key_on(uint8_t key)
+{
+    return key_bits[key>>3] & (1<<(key&7));
+}
+
+static bool report_has_key(uint8_t key)
+{
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        if (keyboard_report->keys[i] == key) return true;
+    }
+    return false;
+}
+
+/* put key into empty slot of 6KRO report, false when report is full */
+static bool report_put_key(uint8_t key)
+{
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        if (!keyboard_report->keys[i]) {
+            keyboard_report->keys[i] = key;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Update keys of keyboard_report from key state. 6KRO keeps keys in their
+ * slot as long as they are on and fills empty slots with keys left out. */
+static void render_keys(void)
+{
+#ifdef NKRO_ENABLE
+    bool nkro = keyboard_protocol && keyboard_nkro;
+    if (nkro != report_nkro) {
+        memset(&keyboard_report->raw[1], 0, KEYBOARD_REPORT_SIZE - 1);
+        report_nkro = nkro;
+    }
+    if (nkro) {
+        memcpy(keyboard_report->nkro.bits, key_bits,
+               KEYBOARD_REPORT_BITS < sizeof(key_bits) ? KEYBOARD_REPORT_BITS : sizeof(key_bits));
+        return;
+    }
+#endif
+
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        uint8_t key = keyboard_report->keys[i];
+        if (!key) continue;
+        if (is_key_on(key)) {
+            n++;
+        } else {
+            keyboard_report->keys[i] = 0;
+        }
+    }
+    if (n == key_count) return;
+
+#ifdef USB_6KRO_ENABLE
+    // newest keys first, older ones roll out of report
+    uint8_t r = recent_head;
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        r = (r ? r : BOOT_REPORT_KEYS) - 1;
+        uint8_t key = recent[r];
+        if (!key || !is_key_on(key) || report_has_key(key)) continue;
+        if (!report_put_key(key)) {
+            // replace first key in report which is not recent
+            for (uint8_t j = 0; j < BOOT_REPORT_KEYS; j++) {
+                bool is_recent = false;
+                for (uint8_t k = 0; k < BOOT_REPORT_KEYS; k++) {
+                    if (recent[k] == keyboard_report->keys[j]) is_recent = true;
+                }
+                if (!is_recent) {
+                    keyboard_report->keys[j] = key;
+                    break;
+                }
+            }
+            continue;
+        }
+        if (++n == key_count) return;
+    }
+#endif
+
+    // fill empty slots with keys left out of report
+    for (uint8_t i = 0; i < sizeof(key_bits) && n < key_count; i++) {
+        uint8_t bits = key_bits[i];
+        while (bits) {
+            uint8_t key = i<<3 | bitctz(bits);
+            bits &= bits - 1;
+            if (report_has_key(key)) continue;
+            if (!report_put_key(key)) return;
+            if (++n == BOOT_REPORT_KEYS) return;
+        }
+    }
+}
+
 void send_keyboard_report(void) {
+    render_keys();
     keyboard_report->mods  = real_mods;
     keyboard_report->mods |= weak_mods;
 #ifndef NO_ACTION_ONESHOT
@@ -75,32 +177,33 @@ void send_keyboard_report(void) {
 /* key */
 void add_key(uint8_t key)
 {
-#ifdef NKRO_ENABLE
-    if (keyboard_protocol && keyboard_nkro) {
-        add_key_bit(key);
-        return;
-    }
+    uint8_t bit = 1<<(key&7);
+    if (!key || (key_bits[key>>3] & bit)) return;
+    key_bits[key>>3] |= bit;
+    key_count++;
+#ifdef USB_6KRO_ENABLE
+    recent[recent_head] = key;
+    recent_head = (recent_head + 1) % BOOT_REPORT_KEYS;
 #endif
-    add_key_byte(key);
 }
 
 void del_key(uint8_t key)
 {
-#ifdef NKRO_ENABLE
-    if (keyboard_protocol && keyboard_nkro) {
-        del_key_bit(key);
-        return;
-    }
-#endif
-    del_key_byte(key);
+    uint8_t bit = 1<<(key&7);
+    if (!(key_bits[key>>3] & bit)) return;
+    key_bits[key>>3] &= ~bit;
+    key_count--;
 }
 
 void clear_keys(void)
 {
     // not clear mods
-    for (int8_t i = 1; i < KEYBOARD_REPORT_SIZE; i++) {
-        keyboard_report->raw[i] = 0;
-    }
+    memset(key_bits, 0, sizeof(key_bits));
+    key_count = 0;
+#ifdef USB_6KRO_ENABLE
+    memset(recent, 0, sizeof(recent));
+    recent_head = 0;
+#endif
 }
 
 
@@ -134,6 +237,10 @@ void clear_oneshot_mods(void)
     oneshot_time = 0;
 #endif
 }
+uint8_t get_oneshot_mods(void)
+{
+    return oneshot_mods;
+}
 #endif
 
 
@@ -144,12 +251,7 @@ void clear_oneshot_mods(void)
  */
 uint8_t has_anykey(void)
 {
-    uint8_t cnt = 0;
-    for (uint8_t i = 1; i < KEYBOARD_REPORT_SIZE; i++) {
-        if (keyboard_report->raw[i])
-            cnt++;
-    }
-    return cnt;
+    return key_count;
 }
 
 uint8_t has_anymod(void)
@@ -161,147 +263,24 @@ uint8_t get_first_key(void)
 {
 #ifdef NKRO_ENABLE
     if (keyboard_protocol && keyboard_nkro) {
-        uint8_t i = 0;
-        for (; i < KEYBOARD_REPORT_BITS && !keyboard_report->nkro.bits[i]; i++)
-            ;
-        return i<<3 | biton(keyboard_report->nkro.bits[i]);
-    }
-#endif
-#ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    do {
-        if (keyboard_report->keys[i] != 0) {
-            break;
-        }
-        i = RO_INC(i);
-    } while (i != cb_tail);
-    return keyboard_report->keys[i];
-#else
-    return keyboard_report->keys[0];
-#endif
-}
-
-
-
-/* local functions */
-static inline void add_key_byte(uint8_t code)
-{
-#ifdef USB_6KRO_ENABLE
-    int8_t i = cb_head;
-    int8_t empty = -1;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                return;
-            }
-            if (empty == -1 && keyboard_report->keys[i] == 0) {
-                empty = i;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-        if (i == cb_tail) {
-            if (cb_tail == cb_head) {
-                // buffer is full
-                if (empty == -1) {
-                    // pop head when has no empty space
-                    cb_head = RO_INC(cb_head);
-                    cb_count--;
-                }
-                else {
-                    // left shift when has empty space
-                    uint8_t offset = 1;
-                    i = RO_INC(empty);
-                    do {
-                        if (keyboard_report->keys[i] != 0) {
-                            keyboard_report->keys[empty] = keyboard_report->keys[i];
-                            keyboard_report->keys[i] = 0;
-                            empty = RO_INC(empty);
-                        }
-                        else {
-                            offset++;
-                        }
-                        i = RO_INC(i);
-                    } while (i != cb_tail);
-                    cb_tail = RO_SUB(cb_tail, offset);
-                }
-            }
-        }
-    }
-    // add to tail
-    keyboard_report->keys[cb_tail] = code;
-    cb_tail = RO_INC(cb_tail);
-    cb_count++;
-#else
-    int8_t i = 0;
-    int8_t empty = -1;
-    for (; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (keyboard_report->keys[i] == code) {
-            break;
-        }
-        if (empty == -1 && keyboard_report->keys[i] == 0) {
-            empty = i;
-        }
-    }
-    if (i == KEYBOARD_REPORT_KEYS) {
-        if (empty != -1) {
-            keyboard_report->keys[empty] = code;
+        for (uint8_t i = 0; i < sizeof(key_bits); i++) {
+            if (key_bits[i]) return i<<3 | bitctz(key_bits[i]);
         }
+        return 0;
     }
 #endif
-}
-
-static inline void del_key_byte(uint8_t code)
-{
+    render_keys();
 #ifdef USB_6KRO_ENABLE
-    uint8_t i = cb_head;
-    if (cb_count) {
-        do {
-            if (keyboard_report->keys[i] == code) {
-                keyboard_report->keys[i] = 0;
-                cb_count--;
-                if (cb_count == 0) {
-                    // reset head and tail
-                    cb_tail = cb_head = 0;
-                }
-                if (i == RO_DEC(cb_tail)) {
-                    // left shift when next to tail
-                    do {
-                        cb_tail = RO_DEC(cb_tail);
-                        if (keyboard_report->keys[RO_DEC(cb_tail)] != 0) {
-                            break;
-                        }
-                    } while (cb_tail != cb_head);
-                }
-                break;
-            }
-            i = RO_INC(i);
-        } while (i != cb_tail);
-    }
-#else
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        if (keyboard_report->keys[i] == code) {
-            keyboard_report->keys[i] = 0;
-        }
+    // oldest key in report
+    uint8_t r = recent_head;
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        uint8_t key = recent[r];
+        if (key && report_has_key(key)) return key;
+        r = (r + 1) % BOOT_REPORT_KEYS;
     }
 #endif
-}
-
-#ifdef NKRO_ENABLE
-static inline void add_key_bit(uint8_t code)
-{
-    if ((code>>3) < KEYBOARD_REPORT_BITS) {
-        keyboard_report->nkro.bits[code>>3] |= 1<<(code&7);
-    } else {
-        dprintf("add_key_bit: can't add: %02X\n", code);
-    }
-}
-
-static inline void del_key_bit(uint8_t code)
-{
-    if ((code>>3) < KEYBOARD_REPORT_BITS) {
-        keyboard_report->nkro.bits[code>>3] &= ~(1<<(code&7));
-    } else {
-        dprintf("del_key_bit: can't del: %02X\n", code);
+    for (uint8_t i = 0; i < BOOT_REPORT_KEYS; i++) {
+        if (keyboard_report->keys[i]) return keyboard_report->keys[i];
     }
+    return 0;
 }
-#endif
@@ -283,6 +283,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define AC_WWW_STOP		ACTION_USAGE_CONSUMER(APPCONTROL_STOP)
 #define AC_WWW_REFRESH		ACTION_USAGE_CONSUMER(APPCONTROL_REFRESH)
 #define AC_WWW_FAVORITES	ACTION_USAGE_CONSUMER(APPCONTROL_BOOKMARKS)
+#define AC_BRIGHTNESS_INC	ACTION_USAGE_CONSUMER(BRIGHTNESS_INCREMENT)
+#define AC_BRIGHTNESS_DEC	ACTION_USAGE_CONSUMER(BRIGHTNESS_DECREMENT)
+#define AC_WORD_PROCESSOR	ACTION_USAGE_CONSUMER(APPLAUNCH_WORD_PROCESSOR)
+#define AC_TEXT_EDITOR		ACTION_USAGE_CONSUMER(APPLAUNCH_TEXT_EDITOR)
+#define AC_SPREADSHEET		ACTION_USAGE_CONSUMER(APPLAUNCH_SPREADSHEET)
+#define AC_GRAPHICS_EDITOR	ACTION_USAGE_CONSUMER(APPLAUNCH_GRAPHICS_EDITOR)
+#define AC_PRESENTATION		ACTION_USAGE_CONSUMER(APPLAUNCH_PRESENTATION)
+#define AC_DATABASE		ACTION_USAGE_CONSUMER(APPLAUNCH_DATABASE)
+#define AC_CALENDAR		ACTION_USAGE_CONSUMER(APPLAUNCH_CALENDAR)
+#define AC_INTERNET_BROWSER	ACTION_USAGE_CONSUMER(APPLAUNCH_INTERNET_BROWSER)
 /* Jump to bootloader */
 #define AC_BOOTLOADER		ACTION_KEY(KC_BOOTLOADER)
 /* Fn key */
@@ -447,6 +457,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define AC_WSTP			ACTION_USAGE_CONSUMER(APPCONTROL_STOP)
 #define AC_WREF			ACTION_USAGE_CONSUMER(APPCONTROL_REFRESH)
 #define AC_WFAV			ACTION_USAGE_CONSUMER(APPCONTROL_BOOKMARKS)
+#define AC_BRIU			ACTION_USAGE_CONSUMER(BRIGHTNESS_INCREMENT)
+#define AC_BRID			ACTION_USAGE_CONSUMER(BRIGHTNESS_DECREMENT)
 /* Jump to bootloader */
 #define AC_BTLD			ACTION_KEY(KC_BOOTLOADER)
 /* Transparent */
@@ -113,9 +113,17 @@ void suspend_power_down(void)
 
 bool suspend_wakeup_condition(void)
 {
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    // timer ISR also scans matrix; it stops in power down sleep
+    uint8_t sreg = SREG;
+    cli();
+#endif
     matrix_power_up();
     matrix_scan();
     matrix_power_down();
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    SREG = sreg;
+#endif
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
         if (matrix_get_row(r)) return true;
     }
@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include "timer_avr.h"
 #include "timer.h"
+#ifdef MATRIX_SCAN_ISR_ENABLE
+#   include "keyboard.h"
+#endif
 
 
 // counter resolution 1ms
@@ -118,4 +121,19 @@ uint32_t timer_elapsed32(uint32_t last)
 ISR(TIMER0_COMPA_vect)
 {
     timer_count++;
+
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    // scan matrix at fixed rate, key events go to keyevent_queue
+    static uint8_t scan_tick = 0;
+    static bool scanning = false;
+    if (!scanning && ++scan_tick >= MATRIX_SCAN_INTERVAL) {
+        scan_tick = 0;
+        scanning = true;
+        // allow USB and timer interrupts during scan
+        sei();
+        keyboard_scan();
+        cli();
+        scanning = false;
+    }
+#endif
 }
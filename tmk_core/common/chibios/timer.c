@@ -1,8 +1,30 @@
 #include "ch.h"
 
 #include "timer.h"
+#ifdef MATRIX_SCAN_ISR_ENABLE
+#   include "keyboard.h"
 
-void timer_init(void) {}
+/* Scan matrix at fixed rate in thread above main loop. Matrix scan waits
+ * between rows which can't be done in ISR context of ChibiOS. */
+static THD_WORKING_AREA(waScanThread, 256);
+static THD_FUNCTION(ScanThread, arg)
+{
+    (void)arg;
+    chRegSetThreadName("scan");
+    systime_t time = chVTGetSystemTime();
+    while (true) {
+        keyboard_scan();
+        time = chThdSleepUntilWindowed(time, time + MS2ST(MATRIX_SCAN_INTERVAL));
+    }
+}
+#endif
+
+void timer_init(void)
+{
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    chThdCreateStatic(waScanThread, sizeof(waScanThread), HIGHPRIO, ScanThread, NULL);
+#endif
+}
 
 void timer_clear(void) {}
 
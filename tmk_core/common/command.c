@@ -33,6 +33,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "led.h"
 #include "command.h"
 #include "backlight.h"
+#include "keyboard_profile.h"
+#include "keyboard_record.h"
+#include "keyevent_queue.h"
 
 #ifdef MOUSEKEY_ENABLE
 #include "mousekey.h"
@@ -49,6 +52,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #   include "usbdrv.h"
 #endif
 
+#ifdef PROTOCOL_LUFA
+#   include "lufa.h"
+#endif
+
 
 static bool command_common(uint8_t code);
 static void command_common_help(void);
@@ -140,6 +147,14 @@ static void command_common_help(void)
 #ifdef SLEEP_LED_ENABLE
           "z:	sleep LED test\n"
 #endif
+
+#ifdef KEYBOARD_PROFILE_ENABLE
+          "p:	profile\n"
+#endif
+
+#ifdef KEYBOARD_RECORD_ENABLE
+          "r:	record dump\n"
+#endif
     );
 }
 
@@ -318,6 +333,24 @@ static bool command_common(uint8_t code)
 #endif
 #ifdef KEYMAP_SECTION_ENABLE
             " KEYMAP_SECTION"
+#endif
+#ifdef KEYBOARD_PROFILE_ENABLE
+            " KEYBOARD_PROFILE"
+#endif
+#ifdef KEYBOARD_RECORD_ENABLE
+            " KEYBOARD_RECORD"
+#endif
+#ifdef MATRIX_SCAN_ISR_ENABLE
+            " MATRIX_SCAN_ISR"
+#endif
+#ifdef LAYER_CACHE_ENABLE
+            " LAYER_CACHE"
+#endif
+#ifdef LAYER_MASK_ENABLE
+            " LAYER_MASK"
+#endif
+#ifdef KEYMAP_COMPILE_ENABLE
+            " KEYMAP_COMPILE"
 #endif
             " " STR(BOOTLOADER_SIZE) "\n");
 
@@ -325,7 +358,7 @@ static bool command_common(uint8_t code)
 #if defined(__AVR__)
                   " AVR-LIBC: " __AVR_LIBC_VERSION_STRING__
                   " AVR_ARCH: avr" STR(__AVR_ARCH__) "\n");
-#elif defined(__arm__)
+#else
             // TODO
             );
 #endif
@@ -339,6 +372,11 @@ static bool command_common(uint8_t code)
             print_val_hex8(keyboard_nkro);
 #endif
             print_val_hex32(timer_read32());
+            print_val_hex16(keyevent_queue_overflow());
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+            print_val_hex16(keyboard_scan_idle_count());
+            print_val_hex16(keyboard_scan_wake_count());
+#endif
 
 #ifdef PROTOCOL_PJRC
             print_val_hex8(UDCON);
@@ -348,12 +386,29 @@ static bool command_common(uint8_t code)
             print_val_hex8(usb_keyboard_idle_count);
 #endif
 
+#ifdef PROTOCOL_LUFA
+            print_val_hex16(lufa_report_dropped);
+            print_val_hex16(lufa_report_coalesced);
+#endif
+
 #ifdef PROTOCOL_PJRC
 #   if USB_COUNT_SOF
             print_val_hex8(usbSofCount);
 #   endif
 #endif
             break;
+#ifdef KEYBOARD_PROFILE_ENABLE
+        case KC_P:
+            profile_print();
+            profile_clear();
+            break;
+#endif
+#ifdef KEYBOARD_RECORD_ENABLE
+        case KC_R:
+            record_dump();
+            record_clear();
+            break;
+#endif
 #ifdef NKRO_ENABLE
         case KC_N:
             clear_keyboard(); //Prevents stuck keys.
@@ -0,0 +1,85 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+#include "timer.h"
+#include "debounce.h"
+
+
+/* bit-sliced counters: bit b of counter of key(row, col) is counter[row][b] bit col */
+static matrix_row_t counter[MATRIX_ROWS][DEBOUNCE_BITS];
+static uint16_t last_tick;
+
+
+void debounce_init(void)
+{
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t b = 0; b < DEBOUNCE_BITS; b++) {
+            counter[r][b] = 0;
+        }
+    }
+    last_tick = timer_read();
+}
+
+bool debounce(const matrix_row_t raw[], matrix_row_t cooked[])
+{
+    bool changed = false;
+
+#if DEBOUNCE == 0
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        if (cooked[r] != raw[r]) {
+            cooked[r] = raw[r];
+            changed = true;
+        }
+    }
+#else
+    // counters advance at most once a millisecond
+    bool tick = false;
+    if (timer_elapsed(last_tick) >= 1) {
+        last_tick = timer_read();
+        tick = true;
+    }
+
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row_t *c = counter[r];
+        matrix_row_t delta = raw[r] ^ cooked[r];
+
+#ifndef DEBOUNCE_DEFER_PRESS
+        // eager press: release is deferred, which covers bounce after press
+        matrix_row_t press = delta & raw[r];
+        if (press) {
+            cooked[r] |= press;
+            delta &= ~press;
+            changed = true;
+        }
+#endif
+
+        // keys settled back to debounced state restart count
+        for (uint8_t b = 0; b < DEBOUNCE_BITS; b++) {
+            c[b] &= delta;
+        }
+        if (!delta || !tick) continue;
+
+        // increment counters of keys in delta: ripple carry through planes
+        matrix_row_t carry = delta;
+        for (uint8_t b = 0; b < DEBOUNCE_BITS && carry; b++) {
+            matrix_row_t t = c[b] & carry;
+            c[b] ^= carry;
+            carry = t;
+        }
+
+        // keys whose counter reached DEBOUNCE
+        matrix_row_t done = delta;
+        for (uint8_t b = 0; b < DEBOUNCE_BITS; b++) {
+            done &= ((DEBOUNCE>>b) & 1) ? c[b] : ~c[b];
+        }
+        if (done) {
+            cooked[r] ^= done;
+            for (uint8_t b = 0; b < DEBOUNCE_BITS; b++) {
+                c[b] &= ~done;
+            }
+            changed = true;
+        }
+    }
+#endif
+    return changed;
+}
@@ -0,0 +1,48 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+
+/*
+ * Per-key debounce
+ *
+ * Each key has its own counter of DEBOUNCE ms, kept bit-sliced in
+ * DEBOUNCE_BITS row-wide planes so a row is processed with a few bitwise ops.
+ *
+ * Press is registered at once(eager) and release only after the switch is
+ * stable for DEBOUNCE ms(deferred), which filters bounce on both edges
+ * without delaying key down. Define DEBOUNCE_DEFER_PRESS in config.h to
+ * defer press as well for switches prone to noise.
+ */
+#ifndef DEBOUNCE
+#   define DEBOUNCE 5
+#endif
+
+#if (DEBOUNCE < 4)
+#   define DEBOUNCE_BITS 2
+#elif (DEBOUNCE < 8)
+#   define DEBOUNCE_BITS 3
+#elif (DEBOUNCE < 16)
+#   define DEBOUNCE_BITS 4
+#else
+#   error "DEBOUNCE: must be less than 16"
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void debounce_init(void);
+/* update debounced matrix 'cooked' with switch states just read into 'raw'
+ * returns true if any key of 'cooked' changed */
+bool debounce(const matrix_row_t raw[], matrix_row_t cooked[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
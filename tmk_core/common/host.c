@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
@@ -31,10 +32,30 @@ static host_driver_t *driver;
 static uint16_t last_system_report = 0;
 static uint16_t last_consumer_report = 0;
 
+/* shadow of reports sent last to suppress duplicates */
+static report_keyboard_t last_keyboard_report;
+static bool last_keyboard_nkro = false;
+static uint8_t last_mouse_buttons = 0;
+
+#ifdef HOST_MOUSE_MERGE
+static report_mouse_t mouse_pending;
+static bool mouse_pending_valid = false;
+#endif
+
 
 void host_set_driver(host_driver_t *d)
 {
     driver = d;
+
+    // new host knows nothing of reports sent so far
+    memset(&last_keyboard_report, 0, sizeof(last_keyboard_report));
+    last_keyboard_nkro = false;
+    last_mouse_buttons = 0;
+    last_system_report = 0;
+    last_consumer_report = 0;
+#ifdef HOST_MOUSE_MERGE
+    mouse_pending_valid = false;
+#endif
 }
 
 host_driver_t *host_get_driver(void)
@@ -51,6 +72,19 @@ uint8_t host_keyboard_leds(void)
 void host_keyboard_send(report_keyboard_t *report)
 {
     if (!driver) return;
+
+    // report format changes with protocol, resend even if bytes are same
+    bool nkro = false;
+#ifdef NKRO_ENABLE
+    nkro = keyboard_protocol && keyboard_nkro;
+#endif
+    if (nkro == last_keyboard_nkro &&
+            !memcmp(report, &last_keyboard_report, sizeof(report_keyboard_t))) {
+        return;
+    }
+    last_keyboard_report = *report;
+    last_keyboard_nkro = nkro;
+
     (*driver->send_keyboard)(report);
 
     if (debug_keyboard) {
@@ -62,10 +96,64 @@ void host_keyboard_send(report_keyboard_t *report)
     }
 }
 
+static void mouse_send(report_mouse_t *report)
+{
+    // no motion and no button change
+    if (!report->x && !report->y && !report->v && !report->h &&
+            report->buttons == last_mouse_buttons) {
+        return;
+    }
+    last_mouse_buttons = report->buttons;
+    (*driver->send_mouse)(report);
+}
+
+#ifdef HOST_MOUSE_MERGE
+static int8_t merge_axis(int8_t a, int8_t b, bool *fit)
+{
+    int16_t sum = (int16_t)a + b;
+    if (sum > 127 || sum < -127) *fit = false;
+    return (int8_t)sum;
+}
+
+/* add motion of 'report' to 'pending', false when it doesn't fit in a report */
+static bool mouse_merge(report_mouse_t *pending, report_mouse_t *report)
+{
+    bool fit = true;
+    report_mouse_t m = *pending;
+    m.x = merge_axis(m.x, report->x, &fit);
+    m.y = merge_axis(m.y, report->y, &fit);
+    m.v = merge_axis(m.v, report->v, &fit);
+    m.h = merge_axis(m.h, report->h, &fit);
+    if (fit) *pending = m;
+    return fit;
+}
+#endif
+
 void host_mouse_send(report_mouse_t *report)
 {
     if (!driver) return;
-    (*driver->send_mouse)(report);
+#ifdef HOST_MOUSE_MERGE
+    if (mouse_pending_valid) {
+        if (report->buttons == mouse_pending.buttons && mouse_merge(&mouse_pending, report)) {
+            return;
+        }
+        host_mouse_flush();
+    }
+    mouse_pending = *report;
+    mouse_pending_valid = true;
+#else
+    mouse_send(report);
+#endif
+}
+
+void host_mouse_flush(void)
+{
+#ifdef HOST_MOUSE_MERGE
+    if (!mouse_pending_valid) return;
+    mouse_pending_valid = false;
+    if (!driver) return;
+    mouse_send(&mouse_pending);
+#endif
 }
 
 void host_system_send(uint16_t report)
@@ -35,6 +35,12 @@ extern bool keyboard_nkro;
 extern uint8_t keyboard_idle;
 extern uint8_t keyboard_protocol;
 
+/*
+ * Reports identical to the last one sent are not sent again. Define
+ * HOST_MOUSE_MERGE in config.h to sum motion of mouse reports with same
+ * buttons within a keyboard_task() and send it once at the end.
+ */
+
 
 /* host driver */
 void host_set_driver(host_driver_t *driver);
@@ -44,6 +50,8 @@ host_driver_t *host_get_driver(void);
 uint8_t host_keyboard_leds(void);
 void host_keyboard_send(report_keyboard_t *report);
 void host_mouse_send(report_mouse_t *report);
+/* send mouse motion merged since last call, see HOST_MOUSE_MERGE */
+void host_mouse_flush(void);
 void host_system_send(uint16_t data);
 void host_consumer_send(uint16_t data);
 
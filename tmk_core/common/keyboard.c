@@ -31,6 +31,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "hook.h"
+#include "keyboard_profile.h"
+#include "keyboard_record.h"
+#include "keyevent_queue.h"
+#include "suspend.h"
 #ifdef MOUSEKEY_ENABLE
 #   include "mousekey.h"
 #endif
@@ -45,20 +49,103 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 
 
+#if (MATRIX_COLS <= 8)
+#   define matrix_row_ctz(bits)    bitctz(bits)
+#elif (MATRIX_COLS <= 16)
+#   define matrix_row_ctz(bits)    bitctz16(bits)
+#else
+#   define matrix_row_ctz(bits)    bitctz32(bits)
+#endif
+
+
+#ifdef MATRIX_SCAN_ISR_ENABLE
+/* keyboard_scan() is not started until initialization completes */
+static volatile bool scan_ready = false;
+/* no console output from ISR */
+#   define scan_matrix_print()
+#else
+#   define scan_matrix_print()  matrix_print()
+#endif
+
+
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+static volatile bool scan_idle = false;
+static uint16_t scan_last = 0;
+static uint16_t scan_last_change = 0;
+static uint16_t scan_idle_count = 0;
+static uint16_t scan_wake_count = 0;
+
+/* whether to scan now, at idle rate only every MATRIX_SCAN_IDLE_INTERVAL */
+static bool scan_due(void)
+{
+    return !scan_idle || timer_elapsed(scan_last) >= MATRIX_SCAN_IDLE_INTERVAL;
+}
+
+/* switches scan rate with result of scan */
+static void scan_rate_update(bool changed)
+{
+    scan_last = timer_read();
+    if (changed) {
+        scan_last_change = scan_last;
+        if (scan_idle) {
+            scan_idle = false;
+            scan_wake_count++;
+        }
+    } else if (!scan_idle &&
+            TIMER_DIFF_16(scan_last, scan_last_change) >= MATRIX_SCAN_IDLE_TIMEOUT) {
+        scan_idle = true;
+        scan_idle_count++;
+    }
+}
+
+uint16_t keyboard_scan_idle_count(void)
+{
+    return scan_idle_count;
+}
+
+uint16_t keyboard_scan_wake_count(void)
+{
+    return scan_wake_count;
+}
+#else
+uint16_t keyboard_scan_idle_count(void) { return 0; }
+uint16_t keyboard_scan_wake_count(void) { return 0; }
+#endif
+
+
 #ifdef MATRIX_HAS_GHOST
-static bool has_ghost_in_row(uint8_t row)
+/* Column occupancy: rows as counted, count of rows on each column and
+ * columns shared by two or more rows. Updated on row change so that ghost
+ * check needs no scan of other rows.
+ */
+static matrix_row_t ghost_rows[MATRIX_ROWS];
+static uint8_t ghost_col_rows[MATRIX_COLS];
+static matrix_row_t ghost_shared_cols;
+
+static void ghost_update(uint8_t row, matrix_row_t matrix_row)
+{
+    matrix_row_t change = matrix_row ^ ghost_rows[row];
+    ghost_rows[row] = matrix_row;
+    while (change) {
+        uint8_t c = matrix_row_ctz(change);
+        matrix_row_t bit = ((matrix_row_t)1<<c);
+        change &= change - 1;
+        if (matrix_row & bit) {
+            if (++ghost_col_rows[c] == 2) ghost_shared_cols |= bit;
+        } else {
+            if (--ghost_col_rows[c] == 1) ghost_shared_cols &= ~bit;
+        }
+    }
+}
+
+static bool has_ghost_in_row(matrix_row_t matrix_row)
 {
-    matrix_row_t matrix_row = matrix_get_row(row);
     // No ghost exists when less than 2 keys are down on the row
     if (((matrix_row - 1) & matrix_row) == 0)
         return false;
 
     // Ghost occurs when the row shares column line with other row
-    for (uint8_t i=0; i < MATRIX_ROWS; i++) {
-        if (i != row && (matrix_get_row(i) & matrix_row))
-            return true;
-    }
-    return false;
+    return (matrix_row & ghost_shared_cols);
 }
 #endif
 
@@ -71,6 +158,8 @@ void keyboard_setup(void)
 void keyboard_init(void)
 {
     timer_init();
+    profile_init();
+    record_init();
     matrix_init();
 #ifdef PS2_MOUSE_ENABLE
     ps2_mouse_init();
@@ -90,71 +179,123 @@ void keyboard_init(void)
 #ifdef BACKLIGHT_ENABLE
     backlight_init();
 #endif
+
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    scan_ready = true;
+#endif
 }
 
 /*
- * Do keyboard routine jobs: scan mantrix, light LEDs, ...
- * This is repeatedly called as fast as possible.
+ * Scan matrix and queue key events of changes
+ * This is called from keyboard_task() or from timer ISR with MATRIX_SCAN_ISR_ENABLE.
  */
-void keyboard_task(void)
+void keyboard_scan(void)
 {
     static matrix_row_t matrix_prev[MATRIX_ROWS];
 #ifdef MATRIX_HAS_GHOST
     static matrix_row_t matrix_ghost[MATRIX_ROWS];
 #endif
-    static uint8_t led_status = 0;
     matrix_row_t matrix_row = 0;
     matrix_row_t matrix_change = 0;
 
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    if (!scan_ready) return;
+#endif
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+    if (!scan_due()) return;
+    bool changed = false;
+#endif
+    PROFILE_START(profile_scan);
+
     matrix_scan();
+#ifdef MATRIX_HAS_GHOST
+    // every row is counted before ghost check of any row
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        ghost_update(r, matrix_get_row(r));
+    }
+#endif
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
         matrix_row = matrix_get_row(r);
         matrix_change = matrix_row ^ matrix_prev[r];
         if (matrix_change) {
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+            changed = true;
+#endif
+            record_matrix(r, matrix_row);
 #ifdef MATRIX_HAS_GHOST
-            if (has_ghost_in_row(r)) {
+            if (has_ghost_in_row(matrix_row)) {
                 /* Keep track of whether ghosted status has changed for
                  * debugging. But don't update matrix_prev until un-ghosted, or
                  * the last key would be lost.
                  */
                 if (debug_matrix && matrix_ghost[r] != matrix_row) {
-                    matrix_print();
+                    scan_matrix_print();
                 }
                 matrix_ghost[r] = matrix_row;
                 continue;
             }
             matrix_ghost[r] = matrix_row;
 #endif
-            if (debug_matrix) matrix_print();
-            for (uint8_t c = 0; c < MATRIX_COLS; c++) {
-                if (matrix_change & ((matrix_row_t)1<<c)) {
-                    keyevent_t e = (keyevent_t){
-                        .key = (keypos_t){ .row = r, .col = c },
-                        .pressed = (matrix_row & ((matrix_row_t)1<<c)),
-                        .time = (timer_read() | 1) /* time should not be 0 */
-                    };
-                    action_exec(e);
-                    hook_matrix_change(e);
-                    // record a processed key
-                    matrix_prev[r] ^= ((matrix_row_t)1<<c);
-
-                    // This can miss stroke when scan matrix takes long like Topre
-                    // process a key per task call
-                    //goto MATRIX_LOOP_END;
-                }
+            if (debug_matrix) scan_matrix_print();
+            // visit only changed columns, from lowest
+            while (matrix_change) {
+                uint8_t c = matrix_row_ctz(matrix_change);
+                matrix_change &= matrix_change - 1;
+                keyevent_t e = (keyevent_t){
+                    .key = (keypos_t){ .row = r, .col = c },
+                    .pressed = (matrix_row & ((matrix_row_t)1<<c)),
+                    .time = (timer_read() | 1) /* time should not be 0 */
+                };
+                // queue full: leave the key unprocessed to retry next scan
+                if (!keyevent_queue_put(e)) break;
+                // record a queued key
+                matrix_prev[r] ^= ((matrix_row_t)1<<c);
             }
         }
     }
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+    scan_rate_update(changed);
+#endif
+    PROFILE_STOP(PROFILE_SCAN, profile_scan);
+}
+
+/*
+ * Do keyboard routine jobs: scan mantrix, light LEDs, ...
+ * This is repeatedly called as fast as possible.
+ */
+void keyboard_task(void)
+{
+    static uint8_t led_status = 0;
+    keyevent_t e;
+    PROFILE_START(profile_task);
+
+#ifndef MATRIX_SCAN_ISR_ENABLE
+    keyboard_scan();
+#endif
+    PROFILE_START(profile_stage);
+
+    // process key events in order of scan, leave them in queue while action
+    // can't take more(tapping is not settled yet)
+    while (action_ready() && keyevent_queue_get(&e)) {
+        PROFILE_START(profile_action);
+        record_event(e);
+        action_exec(e);
+        PROFILE_STOP(PROFILE_ACTION, profile_action);
+        hook_matrix_change(e);
+    }
+    PROFILE_LAP(PROFILE_MATRIX, profile_stage);
+
     // call with pseudo tick event when no real key event.
     action_exec(TICK);
-
-MATRIX_LOOP_END:
+    PROFILE_LAP(PROFILE_ACTION, profile_stage);
 
     hook_keyboard_loop();
+    PROFILE_LAP(PROFILE_HOOK, profile_stage);
 
 #ifdef MOUSEKEY_ENABLE
     // mousekey repeat & acceleration
     mousekey_task();
+    PROFILE_LAP(PROFILE_MOUSEKEY, profile_stage);
 #endif
 
 #ifdef PS2_MOUSE_ENABLE
@@ -169,12 +310,29 @@ MATRIX_LOOP_END:
         adb_mouse_task();
 #endif
 
+#ifdef HOST_MOUSE_MERGE
+    host_mouse_flush();
+#endif
+
+#if defined(PS2_MOUSE_ENABLE) || defined(SERIAL_MOUSE_ENABLE) || defined(ADB_MOUSE_ENABLE)
+    PROFILE_LAP(PROFILE_MOUSE, profile_stage);
+#endif
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
         if (debug_keyboard) dprintf("LED: %02X\n", led_status);
         hook_keyboard_leds_change(led_status);
     }
+    PROFILE_STOP(PROFILE_LED, profile_stage);
+    PROFILE_STOP(PROFILE_TASK, profile_task);
+
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+    // sleep until next interrupt(timer tick at most) while matrix is idle
+    if (scan_idle && keyevent_queue_empty()) {
+        suspend_idle(1);
+    }
+#endif
 }
 
 void keyboard_set_leds(uint8_t leds)
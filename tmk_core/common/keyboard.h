@@ -22,6 +22,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 
 
+/* interval(ms) of matrix scan from timer ISR with MATRIX_SCAN_ISR_ENABLE */
+#ifndef MATRIX_SCAN_INTERVAL
+#   define MATRIX_SCAN_INTERVAL 1
+#endif
+
+/* Adaptive scan rate
+ * Define MATRIX_SCAN_IDLE_TIMEOUT(ms) to scan every MATRIX_SCAN_IDLE_INTERVAL
+ * ms once matrix has not changed for the timeout, MCU sleeps between the
+ * scans. Any change brings back full rate, so first key after idle is seen
+ * late by one idle interval at most.
+ */
+#ifdef MATRIX_SCAN_IDLE_TIMEOUT
+#   ifndef MATRIX_SCAN_IDLE_INTERVAL
+#       define MATRIX_SCAN_IDLE_INTERVAL 10
+#   endif
+#   if MATRIX_SCAN_IDLE_TIMEOUT > 60000
+#       error "MATRIX_SCAN_IDLE_TIMEOUT: must be 60000 or less"
+#   endif
+#endif
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,6 +85,11 @@ void keyboard_setup(void);
 void keyboard_init(void);
 /* it runs repeatedly in main loop */
 void keyboard_task(void);
+/* it scans matrix and queues key events, called from keyboard_task or timer ISR */
+void keyboard_scan(void);
+/* count of scan rate transitions to idle rate and back to full rate */
+uint16_t keyboard_scan_idle_count(void);
+uint16_t keyboard_scan_wake_count(void);
 /* it runs when host LED status is updated */
 void keyboard_set_leds(uint8_t leds);
 
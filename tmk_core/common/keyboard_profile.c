@@ -0,0 +1,129 @@
+#include <stdint.h>
+#include "keyboard_profile.h"
+#include "print.h"
+#include "timer.h"
+
+#if defined(__AVR__)
+#   include <avr/io.h>
+#   include <avr/interrupt.h>
+#elif defined(PROTOCOL_CHIBIOS)
+#   include "ch.h"
+#   include "hal.h"
+#elif defined(PROTOCOL_NATIVE)
+#   include <time.h>
+#endif
+
+
+typedef struct {
+    uint32_t count;
+    uint32_t sum;
+    profile_tick_t min;
+    profile_tick_t max;
+} profile_stat_t;
+
+static profile_stat_t profile_stat[PROFILE_STAGES];
+
+
+void profile_init(void)
+{
+#if defined(PROTOCOL_CHIBIOS) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    profile_clear();
+}
+
+#if defined(__AVR__)
+extern volatile uint32_t timer_count;
+
+/* Timer0 runs in CTC mode and counts 0..TIMER_RAW_TOP every 1ms */
+profile_tick_t profile_read(void)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t ms = (uint16_t)timer_count;
+    uint8_t raw = TIMER_RAW;
+#ifdef TIFR0
+    if ((TIFR0 & (1<<OCF0A)) && raw < TIMER_RAW_TOP/2) ms++;
+#else
+    if ((TIFR & (1<<OCF0A)) && raw < TIMER_RAW_TOP/2) ms++;
+#endif
+    SREG = sreg;
+    return ms * (TIMER_RAW_TOP + 1) + raw;
+}
+#elif defined(PROTOCOL_CHIBIOS)
+profile_tick_t profile_read(void)
+{
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    return DWT->CYCCNT;
+#else
+    /* Cortex-M0 has no cycle counter */
+    return chVTGetSystemTimeX();
+#endif
+}
+#elif defined(PROTOCOL_NATIVE)
+profile_tick_t profile_read(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+#else
+#   error "KEYBOARD_PROFILE: not supported on this platform"
+#endif
+
+void profile_record(uint8_t stage, profile_tick_t ticks)
+{
+    profile_stat_t *s = &profile_stat[stage];
+
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+
+    // halve the accumulation rather than overflow, avg stays valid
+    if ((uint32_t)(s->sum + ticks) < s->sum || s->count == UINT32_MAX) {
+        s->sum >>= 1;
+        s->count >>= 1;
+    }
+    s->sum += ticks;
+    s->count++;
+}
+
+void profile_clear(void)
+{
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+        profile_stat[i].count = 0;
+        profile_stat[i].sum = 0;
+        profile_stat[i].min = (profile_tick_t)~0;
+        profile_stat[i].max = 0;
+    }
+}
+
+static void print_stage(uint8_t stage)
+{
+    switch (stage) {
+        case PROFILE_TASK:      print("task");      break;
+        case PROFILE_SCAN:      print("scan");      break;
+        case PROFILE_MATRIX:    print("matrix");    break;
+        case PROFILE_ACTION:    print("action");    break;
+        case PROFILE_HOOK:      print("hook");      break;
+        case PROFILE_MOUSEKEY:  print("mousekey");  break;
+        case PROFILE_MOUSE:     print("mouse");     break;
+        case PROFILE_LED:       print("led");       break;
+    }
+}
+
+void profile_print(void)
+{
+    print("\n\t- Profile -\n");
+    print("stage\tcount\tmin\tavg\tmax\n");
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+        profile_stat_t *s = &profile_stat[i];
+        if (!s->count) continue;
+        print_stage(i);
+        xprintf("\t%lu\t%lu\t%lu\t%lu\n", (unsigned long)s->count,
+                (unsigned long)s->min,
+                (unsigned long)(s->sum / s->count),
+                (unsigned long)s->max);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef KEYBOARD_PROFILE_H
+#define KEYBOARD_PROFILE_H
+
+#include <stdint.h>
+
+
+/*
+ * Per-stage timing of keyboard_task()
+ *
+ * Each stage keeps count/min/avg/max of its duration in raw ticks:
+ *   AVR:       TIMER_RAW(TCNT0) ticks, F_CPU/TIMER_PRESCALER Hz
+ *   ARM:       DWT cycle counter, core clock(system tick on Cortex-M0)
+ *   native:    nanoseconds of host monotonic clock
+ */
+enum profile_stage {
+    PROFILE_TASK = 0,   /* whole keyboard_task() */
+    PROFILE_SCAN,       /* keyboard_scan(): matrix_scan() and row diff loop */
+    PROFILE_MATRIX,     /* action_exec() of queued key events */
+    PROFILE_ACTION,     /* each action_exec() call including TICK */
+    PROFILE_HOOK,       /* hook_keyboard_loop() */
+    PROFILE_MOUSEKEY,   /* mousekey_task() */
+    PROFILE_MOUSE,      /* ps2/serial/adb mouse task */
+    PROFILE_LED,        /* LED sync */
+    PROFILE_STAGES
+};
+
+
+#ifdef KEYBOARD_PROFILE_ENABLE
+
+#if defined(__AVR__)
+typedef uint16_t profile_tick_t;
+#else
+typedef uint32_t profile_tick_t;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void profile_init(void);
+profile_tick_t profile_read(void);
+void profile_record(uint8_t stage, profile_tick_t ticks);
+void profile_clear(void);
+void profile_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define PROFILE_START(t)        profile_tick_t t = profile_read()
+#define PROFILE_STOP(stage, t)  profile_record((stage), profile_read() - (t))
+/* record time since 't' and restart 't' for next stage */
+#define PROFILE_LAP(stage, t)   do { \
+    profile_tick_t profile_now_ = profile_read(); \
+    profile_record((stage), profile_now_ - (t)); \
+    (t) = profile_now_; \
+} while (0)
+
+#else
+
+#define profile_init()
+#define profile_clear()
+#define profile_print()
+#define PROFILE_START(t)
+#define PROFILE_STOP(stage, t)
+#define PROFILE_LAP(stage, t)
+
+#endif
+
+#endif
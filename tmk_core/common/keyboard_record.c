@@ -0,0 +1,150 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "keyboard_record.h"
+#include "timer.h"
+#include "print.h"
+
+#if defined(__AVR__)
+#   include <avr/io.h>
+#   include <avr/interrupt.h>
+/* entries are put from timer ISR with MATRIX_SCAN_ISR_ENABLE */
+#   define RECORD_LOCK()    uint8_t sreg_ = SREG; cli()
+#   define RECORD_UNLOCK()  SREG = sreg_
+#elif defined(PROTOCOL_CHIBIOS)
+#   include "ch.h"
+/* entries are put from scan thread with MATRIX_SCAN_ISR_ENABLE */
+#   define RECORD_LOCK()    chSysLock()
+#   define RECORD_UNLOCK()  chSysUnlock()
+#else
+#   define RECORD_LOCK()
+#   define RECORD_UNLOCK()
+#endif
+
+
+#if (RECORD_BUFFER_SIZE & (RECORD_BUFFER_SIZE - 1)) || RECORD_BUFFER_SIZE > 0x8000
+#   error "RECORD_BUFFER_SIZE: must be power of 2 up to 32768"
+#endif
+#define RECORD_MASK     (RECORD_BUFFER_SIZE - 1)
+/* tag, delta up to 5 bytes and data */
+#define RECORD_ENTRY_MAX    (1 + 5 + (sizeof(matrix_row_t) > 2 ? sizeof(matrix_row_t) : 2))
+
+static uint8_t record_buf[RECORD_BUFFER_SIZE];
+static uint16_t record_head = 0;
+static uint16_t record_tail = 0;
+/* time of entry before oldest one and time of newest one */
+static uint32_t record_base = 0;
+static uint32_t record_last = 0;
+static volatile bool record_paused = false;
+/* rows as recorded last */
+static matrix_row_t record_rows[MATRIX_ROWS];
+
+
+static uint8_t record_data_len(uint8_t tag)
+{
+    return (tag & RECORD_TAG_EVENT) ? 2 : sizeof(matrix_row_t);
+}
+
+/* drops oldest entry and moves base time to it */
+static void record_drop(void)
+{
+    uint8_t tag = record_buf[record_tail];
+    uint32_t zz = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    record_tail = (record_tail + 1) & RECORD_MASK;
+    do {
+        b = record_buf[record_tail];
+        record_tail = (record_tail + 1) & RECORD_MASK;
+        zz |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    record_base += (int32_t)((zz >> 1) ^ -(zz & 1));
+    record_tail = (record_tail + record_data_len(tag)) & RECORD_MASK;
+}
+
+static void record_put(uint32_t time, uint8_t tag, const uint8_t *data)
+{
+    uint8_t entry[RECORD_ENTRY_MAX];
+    uint8_t len = 0;
+
+    RECORD_LOCK();
+    entry[len++] = tag;
+    int32_t delta = time - record_last;
+    uint32_t zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    while (zz >= 0x80) {
+        entry[len++] = zz | 0x80;
+        zz >>= 7;
+    }
+    entry[len++] = zz;
+    for (uint8_t i = 0; i < record_data_len(tag); i++) {
+        entry[len++] = data[i];
+    }
+
+    if (!record_paused) {
+        // one byte is kept free to tell full from empty
+        while (((record_tail - record_head - 1) & RECORD_MASK) < len) {
+            record_drop();
+        }
+        for (uint8_t i = 0; i < len; i++) {
+            record_buf[record_head] = entry[i];
+            record_head = (record_head + 1) & RECORD_MASK;
+        }
+        record_last = time;
+    }
+    RECORD_UNLOCK();
+}
+
+void record_init(void)
+{
+    record_clear();
+}
+
+void record_clear(void)
+{
+    // timer of ChibiOS is not read in locked state
+    uint32_t now = timer_read32();
+    RECORD_LOCK();
+    record_head = record_tail = 0;
+    record_base = record_last = now;
+    RECORD_UNLOCK();
+}
+
+/* called on change of row, row is recorded only when it differs from last */
+void record_matrix(uint8_t row, matrix_row_t bits)
+{
+    if (bits == record_rows[row]) return;
+    record_rows[row] = bits;
+
+    uint8_t data[sizeof(matrix_row_t)];
+    for (uint8_t i = 0; i < sizeof(matrix_row_t); i++) {
+        data[i] = bits >> (i * 8);
+    }
+    record_put(timer_read32(), row & RECORD_TAG_ROW, data);
+}
+
+void record_event(keyevent_t event)
+{
+    // extend 16-bit event time with current time, it can be ahead by 1ms
+    // as it is made odd
+    uint32_t now = timer_read32();
+    uint32_t time = now - (int16_t)((uint16_t)now - event.time);
+
+    uint8_t data[2] = { event.key.row, event.key.col };
+    record_put(time, RECORD_TAG_EVENT | (event.pressed ? RECORD_TAG_PRESSED : 0), data);
+}
+
+void record_dump(void)
+{
+    record_paused = true;
+    print("record: "); print_dec(MATRIX_ROWS);
+    print(" "); print_dec((uint8_t)sizeof(matrix_row_t));
+    print(" "); print_hex32((unsigned long)record_base);
+    print(" "); print_dec((record_head - record_tail) & RECORD_MASK);
+    uint8_t n = 0;
+    for (uint16_t i = record_tail; i != record_head; i = (i + 1) & RECORD_MASK) {
+        if (n++ % 32 == 0) print("\n:");
+        print_hex8(record_buf[i]);
+    }
+    print("\n");
+    record_paused = false;
+}
@@ -0,0 +1,64 @@
+#ifndef KEYBOARD_RECORD_H
+#define KEYBOARD_RECORD_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "keyboard.h"
+
+
+/*
+ * Recorder of matrix changes and action_exec() inputs
+ *
+ * Entries are kept in a ring buffer, oldest are dropped when it is full.
+ * Each entry is:
+ *   tag    1 byte  0rrrrrrr: row change, r is row
+ *                  1p000000: key event of action_exec(), p is pressed
+ *   delta  varint  ms since previous entry, zigzag encoded as events may be
+ *                  stamped earlier than a row change recorded before them,
+ *                  7 bits per byte from lowest, bit7 is set but last byte
+ *   data   row change: matrix_row_t, little endian
+ *          key event:  row, col
+ *
+ * record_dump() prints buffer to console:
+ *   record: <rows> <bytes of matrix_row_t> <base time(ms, hex)> <length>
+ *   :<hex bytes, up to 32 per line>
+ * Time of first entry is base time plus its delta. Rows before first entry
+ * are unknown and taken as all released. native_record_load() of host build
+ * reads it back as trace.
+ */
+#ifndef RECORD_BUFFER_SIZE
+#define RECORD_BUFFER_SIZE  256
+#endif
+
+#define RECORD_TAG_EVENT    0x80
+#define RECORD_TAG_PRESSED  0x40
+#define RECORD_TAG_ROW      0x7F
+
+
+#ifdef KEYBOARD_RECORD_ENABLE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void record_init(void);
+void record_matrix(uint8_t row, matrix_row_t bits);
+void record_event(keyevent_t event);
+void record_clear(void);
+void record_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+
+#define record_init()
+#define record_matrix(row, bits)
+#define record_event(event)
+#define record_clear()
+#define record_dump()
+
+#endif
+
+#endif
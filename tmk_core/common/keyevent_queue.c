@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "keyboard.h"
+#include "keyevent_queue.h"
+
+
+/* Only producer writes head and only consumer writes tail; both run free and
+ * (head - tail) is the number of queued events. On single core a compiler
+ * barrier is enough to publish slot before index. */
+#define QUEUE_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+#define QUEUE_MASK      (KEYEVENT_QUEUE_SIZE - 1)
+
+static keyevent_t queue[KEYEVENT_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint16_t overflow = 0;
+
+
+bool keyevent_queue_put(keyevent_t event)
+{
+    uint8_t h = head;
+    if ((uint8_t)(h - tail) >= KEYEVENT_QUEUE_SIZE) {
+        if (overflow != 0xFFFF) overflow++;
+        return false;
+    }
+    queue[h & QUEUE_MASK] = event;
+    QUEUE_BARRIER();
+    head = h + 1;
+    return true;
+}
+
+bool keyevent_queue_get(keyevent_t *event)
+{
+    uint8_t t = tail;
+    if (t == head) return false;
+    QUEUE_BARRIER();
+    *event = queue[t & QUEUE_MASK];
+    QUEUE_BARRIER();
+    tail = t + 1;
+    return true;
+}
+
+bool keyevent_queue_empty(void)
+{
+    return head == tail;
+}
+
+uint16_t keyevent_queue_overflow(void)
+{
+    return overflow;
+}
+
+void keyevent_queue_clear(void)
+{
+    tail = head;
+    overflow = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef KEYEVENT_QUEUE_H
+#define KEYEVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "keyboard.h"
+
+
+/*
+ * Key event queue between matrix scan and action processing
+ *
+ * Single producer(matrix scan, possibly in ISR) and single consumer
+ * (keyboard_task) without lock. Event is time-stamped when the scan finds it
+ * so slow action processing doesn't make it late. When the queue is full
+ * put fails and is counted in overflow; the producer should keep the key
+ * unprocessed and retry it in next scan, then no key is lost.
+ */
+#ifndef KEYEVENT_QUEUE_SIZE
+#   define KEYEVENT_QUEUE_SIZE 8
+#endif
+
+#if (KEYEVENT_QUEUE_SIZE & (KEYEVENT_QUEUE_SIZE - 1)) || (KEYEVENT_QUEUE_SIZE > 128)
+#   error "KEYEVENT_QUEUE_SIZE must be power of 2 and not exceed 128"
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* producer side: returns false when queue is full */
+bool keyevent_queue_put(keyevent_t event);
+/* consumer side: returns false when queue is empty */
+bool keyevent_queue_get(keyevent_t *event);
+bool keyevent_queue_empty(void);
+/* number of events rejected because of full queue */
+uint16_t keyevent_queue_overflow(void);
+/* call only when producer is not running */
+void keyevent_queue_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -47,6 +47,9 @@ uint8_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 /* translates Fn keycode to action */
 action_t keymap_fn_to_action(uint8_t keycode);
 
+/* translates keycode to action, used by action_for_key() */
+action_t keymap_keycode_to_action(uint8_t keycode);
+
 
 
 #ifdef USE_LEGACY_KEYMAP
@@ -0,0 +1,52 @@
+#include <stdint.h>
+#include "keyboard.h"
+#include "keycode.h"
+#include "action.h"
+#include "keymap.h"
+#include "progmem.h"
+
+
+/*
+ * Keymap flattened to action of each layer and key by tool/keymap_compile
+ * at build, so that resolving action is just a table lookup.
+ */
+extern const uint8_t keymap_compiled_layers;
+extern const action_t keymap_compiled_actions[][MATRIX_ROWS][MATRIX_COLS];
+#ifndef ACTIONMAP_ENABLE
+/* bit of key is set when its action is keycode of keymap, not of fn_actions */
+extern const uint8_t keymap_compiled_keycodes[][MATRIX_ROWS][(MATRIX_COLS + 7) / 8];
+#endif
+
+
+action_t action_for_key(uint8_t layer, keypos_t key)
+{
+    if (layer >= pgm_read_byte(&keymap_compiled_layers)) {
+        return (action_t)ACTION_TRANSPARENT;
+    }
+    action_t action = (action_t)pgm_read_word(&keymap_compiled_actions[layer][key.row][key.col]);
+
+#ifndef ACTIONMAP_ENABLE
+    // keycodes which depend on runtime config or act when resolved, same
+    // action from fn_actions is left as it is
+    switch (action.code) {
+#ifdef BOOTMAGIC_ENABLE
+        case KC_CAPSLOCK:
+        case KC_LOCKING_CAPS:
+        case KC_LCTL:
+        case KC_LALT:
+        case KC_LGUI:
+        case KC_RALT:
+        case KC_RGUI:
+        case KC_GRAVE:
+        case KC_ESC:
+        case KC_BSLASH:
+        case KC_BSPACE:
+#endif
+        case KC_BOOTLOADER:
+            if (pgm_read_byte(&keymap_compiled_keycodes[layer][key.row][key.col / 8]) & (1<<(key.col % 8))) {
+                return keymap_keycode_to_action(action.code);
+            }
+    }
+#endif
+    return action;
+}
@@ -1,6 +1,8 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 
+void suspend_idle(uint8_t time) {}
 void suspend_power_down(void) {}
 bool suspend_wakeup_condition(void) { return true; }
 void suspend_wakeup_init(void) {}
@@ -0,0 +1,11 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bootloader.h"
+
+
+/* No bootloader on host; just end simulation. */
+void bootloader_jump(void)
+{
+    printf("bootloader_jump\n");
+    exit(0);
+}
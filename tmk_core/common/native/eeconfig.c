@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "eeconfig.h"
+
+
+/* EEPROM emulation on RAM, erased state is 0xFF like real one. */
+#define EEPROM_SIZE 64
+static uint8_t eeprom[EEPROM_SIZE] = {
+    [0 ... EEPROM_SIZE-1] = 0xFF
+};
+
+static uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+    return eeprom[(uintptr_t)addr];
+}
+
+static void eeprom_write_byte(uint8_t *addr, uint8_t val)
+{
+    eeprom[(uintptr_t)addr] = val;
+}
+
+static uint16_t eeprom_read_word(const uint16_t *addr)
+{
+    uintptr_t p = (uintptr_t)addr;
+    return eeprom[p] | (eeprom[p+1]<<8);
+}
+
+static void eeprom_write_word(uint16_t *addr, uint16_t val)
+{
+    uintptr_t p = (uintptr_t)addr;
+    eeprom[p] = val & 0xFF;
+    eeprom[p+1] = val>>8;
+}
+
+void eeconfig_init(void)
+{
+    eeprom_write_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
+    eeprom_write_byte(EECONFIG_DEBUG,          0);
+    eeprom_write_byte(EECONFIG_DEFAULT_LAYER,  0);
+    eeprom_write_byte(EECONFIG_KEYMAP,         0);
+    eeprom_write_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+#ifdef BACKLIGHT_ENABLE
+    eeprom_write_byte(EECONFIG_BACKLIGHT,      0);
+#endif
+}
+
+void eeconfig_enable(void)
+{
+    eeprom_write_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+}
+
+void eeconfig_disable(void)
+{
+    eeprom_write_word(EECONFIG_MAGIC, 0xFFFF);
+}
+
+bool eeconfig_is_enabled(void)
+{
+    return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
+}
+
+uint8_t eeconfig_read_debug(void)      { return eeprom_read_byte(EECONFIG_DEBUG); }
+void eeconfig_write_debug(uint8_t val) { eeprom_write_byte(EECONFIG_DEBUG, val); }
+
+uint8_t eeconfig_read_default_layer(void)      { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
+void eeconfig_write_default_layer(uint8_t val) { eeprom_write_byte(EECONFIG_DEFAULT_LAYER, val); }
+
+uint8_t eeconfig_read_keymap(void)      { return eeprom_read_byte(EECONFIG_KEYMAP); }
+void eeconfig_write_keymap(uint8_t val) { eeprom_write_byte(EECONFIG_KEYMAP, val); }
+
+#ifdef BACKLIGHT_ENABLE
+uint8_t eeconfig_read_backlight(void)      { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
+void eeconfig_write_backlight(uint8_t val) { eeprom_write_byte(EECONFIG_BACKLIGHT, val); }
+#endif
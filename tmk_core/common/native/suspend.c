@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+#include "action.h"
+#include "action_util.h"
+#include "timer.h"
+#include "suspend.h"
+
+
+void suspend_idle(uint8_t time)
+{
+    timer_advance_us((uint32_t)time * 1000);
+}
+
+void suspend_power_down(void)
+{
+    // same as watchdog sleep of AVR: WDTO_15MS + 2(from observation)
+    timer_advance_us(17 * 1000UL);
+}
+
+bool suspend_wakeup_condition(void)
+{
+    matrix_power_up();
+    matrix_scan();
+    matrix_power_down();
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        if (matrix_get_row(r)) return true;
+    }
+    return false;
+}
+
+// run immediately after wakeup
+void suspend_wakeup_init(void)
+{
+    // clear keyboard state
+    matrix_clear();
+    clear_keyboard();
+}
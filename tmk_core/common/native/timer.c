@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include "timer_native.h"
+#include "timer.h"
+
+
+// counter resolution 1ms, same as AVR
+volatile uint32_t timer_count = 0;
+// sub-millisecond part and total of virtual clock
+static uint16_t timer_count_us = 0;
+static uint32_t timer_total_us = 0;
+
+void timer_init(void)
+{
+}
+
+void timer_clear(void)
+{
+    timer_count = 0;
+    timer_count_us = 0;
+    timer_total_us = 0;
+}
+
+uint16_t timer_read(void)
+{
+    return (timer_count & 0xFFFF);
+}
+
+uint32_t timer_read32(void)
+{
+    return timer_count;
+}
+
+uint16_t timer_elapsed(uint16_t last)
+{
+    return TIMER_DIFF_16((timer_count & 0xFFFF), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last)
+{
+    return TIMER_DIFF_32(timer_count, last);
+}
+
+void timer_advance_us(uint32_t us)
+{
+    timer_total_us += us;
+    us += timer_count_us;
+    timer_count += us / 1000;
+    timer_count_us = us % 1000;
+}
+
+uint32_t timer_read_us(void)
+{
+    return timer_total_us;
+}
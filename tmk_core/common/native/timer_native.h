@@ -0,0 +1,23 @@
+#ifndef TIMER_NATIVE_H
+#define TIMER_NATIVE_H 1
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Virtual clock of host build
+ *
+ * Nothing ticks by itself; the simulator advances the clock explicitly and
+ * blocking waits(wait_ms/wait_us) advance it as well.
+ */
+void timer_advance_us(uint32_t us);
+/* virtual time in microseconds since timer_clear() */
+uint32_t timer_read_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -55,6 +55,15 @@ void print_set_sendchar(int8_t (*print_sendchar_func)(uint8_t));
 #define println(s)  printf(s "\r\n")
 #define xprintf  printf
 
+#elif defined(PROTOCOL_NATIVE) /* __AVR__ */
+
+#include <stdio.h>
+
+#define print(s)    printf(s)
+#define println(s)  printf(s "\r\n")
+#define xprintf  printf
+#define print_set_sendchar(func)
+
 #elif defined(__arm__) /* __AVR__ */
 
 #include "mbed/xprintf.h"
@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include "keycode.h"
+#include "report.h"
+#include "progmem.h"
+
+
+/* Generic Desktop usage of KC_SYSTEM_POWER...KC_SYSTEM_WAKE */
+const uint16_t PROGMEM keycode_to_system[] = {
+    [KC_SYSTEM_POWER        - KC_SYSTEM_POWER] = SYSTEM_POWER_DOWN,
+    [KC_SYSTEM_SLEEP        - KC_SYSTEM_POWER] = SYSTEM_SLEEP,
+    [KC_SYSTEM_WAKE         - KC_SYSTEM_POWER] = SYSTEM_WAKE_UP,
+};
+
+/* Consumer usage of KC_AUDIO_MUTE...KC_BRIGHTNESS_DEC */
+const uint16_t PROGMEM keycode_to_consumer[] = {
+    [KC_AUDIO_MUTE          - KC_AUDIO_MUTE] = AUDIO_MUTE,
+    [KC_AUDIO_VOL_UP        - KC_AUDIO_MUTE] = AUDIO_VOL_UP,
+    [KC_AUDIO_VOL_DOWN      - KC_AUDIO_MUTE] = AUDIO_VOL_DOWN,
+    [KC_MEDIA_NEXT_TRACK    - KC_AUDIO_MUTE] = TRANSPORT_NEXT_TRACK,
+    [KC_MEDIA_PREV_TRACK    - KC_AUDIO_MUTE] = TRANSPORT_PREV_TRACK,
+    [KC_MEDIA_FAST_FORWARD  - KC_AUDIO_MUTE] = TRANSPORT_FAST_FORWARD,
+    [KC_MEDIA_REWIND        - KC_AUDIO_MUTE] = TRANSPORT_REWIND,
+    [KC_MEDIA_STOP          - KC_AUDIO_MUTE] = TRANSPORT_STOP,
+    [KC_MEDIA_PLAY_PAUSE    - KC_AUDIO_MUTE] = TRANSPORT_PLAY_PAUSE,
+    [KC_MEDIA_EJECT         - KC_AUDIO_MUTE] = TRANSPORT_STOP_EJECT,
+    [KC_MEDIA_SELECT        - KC_AUDIO_MUTE] = APPLAUNCH_CC_CONFIG,
+    [KC_MAIL                - KC_AUDIO_MUTE] = APPLAUNCH_EMAIL,
+    [KC_CALCULATOR          - KC_AUDIO_MUTE] = APPLAUNCH_CALCULATOR,
+    [KC_MY_COMPUTER         - KC_AUDIO_MUTE] = APPLAUNCH_LOCAL_BROWSER,
+    [KC_WWW_SEARCH          - KC_AUDIO_MUTE] = APPCONTROL_SEARCH,
+    [KC_WWW_HOME            - KC_AUDIO_MUTE] = APPCONTROL_HOME,
+    [KC_WWW_BACK            - KC_AUDIO_MUTE] = APPCONTROL_BACK,
+    [KC_WWW_FORWARD         - KC_AUDIO_MUTE] = APPCONTROL_FORWARD,
+    [KC_WWW_STOP            - KC_AUDIO_MUTE] = APPCONTROL_STOP,
+    [KC_WWW_REFRESH         - KC_AUDIO_MUTE] = APPCONTROL_REFRESH,
+    [KC_WWW_FAVORITES       - KC_AUDIO_MUTE] = APPCONTROL_BOOKMARKS,
+    [KC_BRIGHTNESS_INC      - KC_AUDIO_MUTE] = BRIGHTNESS_INCREMENT,
+    [KC_BRIGHTNESS_DEC      - KC_AUDIO_MUTE] = BRIGHTNESS_DECREMENT,
+};
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 #include "keycode.h"
+#include "progmem.h"
 
 
 /* report id */
@@ -58,6 +59,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define APPCONTROL_STOP         0x0226
 #define APPCONTROL_REFRESH      0x0227
 #define APPCONTROL_BOOKMARKS    0x022A
+/* display */
+#define BRIGHTNESS_INCREMENT    0x006F
+#define BRIGHTNESS_DECREMENT    0x0070
+/* application launch, no keycode; for actionmap */
+#define APPLAUNCH_WORD_PROCESSOR    0x0184
+#define APPLAUNCH_TEXT_EDITOR       0x0185
+#define APPLAUNCH_SPREADSHEET       0x0186
+#define APPLAUNCH_GRAPHICS_EDITOR   0x0187
+#define APPLAUNCH_PRESENTATION      0x0188
+#define APPLAUNCH_DATABASE          0x0189
+#define APPLAUNCH_CALENDAR          0x018E
+#define APPLAUNCH_INTERNET_BROWSER  0x0196
 /* supplement for Bluegiga iWRAP HID(not supported by Windows?) */
 #define APPLAUNCH_LOCK          0x019E
 #define TRANSPORT_RECORD        0x00B2
@@ -89,6 +102,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #   define KEYBOARD_REPORT_SIZE NKRO_EPSIZE
 #   define KEYBOARD_REPORT_KEYS (NKRO_EPSIZE - 2)
 #   define KEYBOARD_REPORT_BITS (NKRO_EPSIZE - 1)
+#elif defined(PROTOCOL_NATIVE) && defined(NKRO_ENABLE)
+    /* same as NKRO_EPSIZE of LUFA */
+#   define KEYBOARD_REPORT_SIZE 32
+#   define KEYBOARD_REPORT_KEYS (32 - 2)
+#   define KEYBOARD_REPORT_BITS (32 - 1)
 
 #else
 #   define KEYBOARD_REPORT_SIZE 8
@@ -151,35 +169,12 @@ typedef struct {
 } __attribute__ ((packed)) report_mouse_t;
 
 
-/* keycode to system usage */
-#define KEYCODE2SYSTEM(key) \
-    (key == KC_SYSTEM_POWER ? SYSTEM_POWER_DOWN : \
-    (key == KC_SYSTEM_SLEEP ? SYSTEM_SLEEP : \
-    (key == KC_SYSTEM_WAKE  ? SYSTEM_WAKE_UP : 0)))
-
-/* keycode to consumer usage */
-#define KEYCODE2CONSUMER(key) \
-    (key == KC_AUDIO_MUTE           ?  AUDIO_MUTE : \
-    (key == KC_AUDIO_VOL_UP         ?  AUDIO_VOL_UP : \
-    (key == KC_AUDIO_VOL_DOWN       ?  AUDIO_VOL_DOWN : \
-    (key == KC_MEDIA_NEXT_TRACK     ?  TRANSPORT_NEXT_TRACK : \
-    (key == KC_MEDIA_PREV_TRACK     ?  TRANSPORT_PREV_TRACK : \
-    (key == KC_MEDIA_FAST_FORWARD   ?  TRANSPORT_FAST_FORWARD : \
-    (key == KC_MEDIA_REWIND         ?  TRANSPORT_REWIND : \
-    (key == KC_MEDIA_STOP           ?  TRANSPORT_STOP : \
-    (key == KC_MEDIA_EJECT          ?  TRANSPORT_STOP_EJECT : \
-    (key == KC_MEDIA_PLAY_PAUSE     ?  TRANSPORT_PLAY_PAUSE : \
-    (key == KC_MEDIA_SELECT         ?  APPLAUNCH_CC_CONFIG : \
-    (key == KC_MAIL                 ?  APPLAUNCH_EMAIL : \
-    (key == KC_CALCULATOR           ?  APPLAUNCH_CALCULATOR : \
-    (key == KC_MY_COMPUTER          ?  APPLAUNCH_LOCAL_BROWSER : \
-    (key == KC_WWW_SEARCH           ?  APPCONTROL_SEARCH : \
-    (key == KC_WWW_HOME             ?  APPCONTROL_HOME : \
-    (key == KC_WWW_BACK             ?  APPCONTROL_BACK : \
-    (key == KC_WWW_FORWARD          ?  APPCONTROL_FORWARD : \
-    (key == KC_WWW_STOP             ?  APPCONTROL_STOP : \
-    (key == KC_WWW_REFRESH          ?  APPCONTROL_REFRESH : \
-    (key == KC_WWW_FAVORITES        ?  APPCONTROL_BOOKMARKS : 0)))))))))))))))))))))
+/* keycode to usage, tables in report.c
+ * key must be in range of IS_SYSTEM() and IS_CONSUMER() respectively */
+extern const uint16_t keycode_to_system[];
+extern const uint16_t keycode_to_consumer[];
+#define KEYCODE2SYSTEM(key)     pgm_read_word(&keycode_to_system[(key) - KC_SYSTEM_POWER])
+#define KEYCODE2CONSUMER(key)   pgm_read_word(&keycode_to_consumer[(key) - KC_AUDIO_MUTE])
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #if defined(__AVR__)
 #include "avr/timer_avr.h"
+#elif defined(PROTOCOL_NATIVE)
+#include "native/timer_native.h"
 #endif
 
 
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "util.h"
+#include "progmem.h"
 
 // bit population - return number of on-bit
 uint8_t bitpop(uint8_t bits)
@@ -78,6 +79,47 @@ uint8_t biton32(uint32_t bits)
     return n;
 }
 
+// least significant on-bit - return lowest location of on-bit
+// NOTE: return 0 when bit0 is on or all bits are off
+#if defined(__AVR__)
+// AVR has no instruction for this, look up low location in nibble
+static const uint8_t PROGMEM ctz_nibble[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+
+uint8_t bitctz(uint8_t bits)
+{
+    if (bits & 0x0F) return pgm_read_byte(&ctz_nibble[bits & 0x0F]);
+    if (bits) return 4 + pgm_read_byte(&ctz_nibble[bits >> 4]);
+    return 0;
+}
+
+uint8_t bitctz16(uint16_t bits)
+{
+    if (bits & 0x00FF) return bitctz(bits);
+    return bitctz(bits >> 8) + ((bits >> 8) ? 8 : 0);
+}
+
+uint8_t bitctz32(uint32_t bits)
+{
+    if (bits & 0x0000FFFF) return bitctz16(bits);
+    return bitctz16(bits >> 16) + ((bits >> 16) ? 16 : 0);
+}
+#else
+uint8_t bitctz(uint8_t bits)
+{
+    return bits ? __builtin_ctz(bits) : 0;
+}
+
+uint8_t bitctz16(uint16_t bits)
+{
+    return bits ? __builtin_ctz(bits) : 0;
+}
+
+uint8_t bitctz32(uint32_t bits)
+{
+    return bits ? __builtin_ctzl(bits) : 0;
+}
+#endif
+
 
 
 uint8_t bitrev(uint8_t bits)
@@ -13,6 +13,10 @@ extern "C" {
 #   include "ch.h"
 #   define wait_ms(ms) chThdSleepMilliseconds(ms)
 #   define wait_us(us) chThdSleepMicroseconds(us)
+#elif defined(PROTOCOL_NATIVE) /* __AVR__ */
+#   include "timer.h"
+#   define wait_ms(ms)  timer_advance_us((uint32_t)(ms) * 1000)
+#   define wait_us(us)  timer_advance_us(us)
 #elif defined(__arm__) /* __AVR__ */
 #   include "wait_api.h"
 #endif /* __AVR__ */
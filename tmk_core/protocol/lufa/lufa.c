@@ -69,6 +69,9 @@ static uint8_t keyboard_led_stats = 0;
 
 static report_keyboard_t keyboard_report_sent;
 
+uint16_t lufa_report_dropped = 0;
+uint16_t lufa_report_coalesced = 0;
+
 
 /* Host driver */
 static uint8_t keyboard_leds(void);
@@ -85,6 +88,200 @@ host_driver_t lufa_driver = {
 };
 
 
+/*******************************************************************************
+ * Report FIFO
+ *
+ * Reports are queued per endpoint and written when its bank is free, at once
+ * from host driver or later from SOF interrupt, so that sending never waits
+ * for host polling. When FIFO is full the newest report replaces the last one
+ * and it is counted as dropped.
+ ******************************************************************************/
+#ifndef REPORT_FIFO_SIZE
+#   define REPORT_FIFO_SIZE 4
+#endif
+#if (REPORT_FIFO_SIZE & (REPORT_FIFO_SIZE - 1))
+#   error "REPORT_FIFO_SIZE must be power of 2"
+#endif
+#define FIFO_MASK           (REPORT_FIFO_SIZE - 1)
+/* index of oldest and newest entry */
+#define FIFO_FIRST(f)       (((f).head - (f).count) & FIFO_MASK)
+#define FIFO_LAST(f)        (((f).head - 1) & FIFO_MASK)
+
+static struct {
+    report_keyboard_t report[REPORT_FIFO_SIZE];
+    uint8_t head;
+    uint8_t count;
+} keyboard_fifo;
+
+#ifdef MOUSE_ENABLE
+static struct {
+    report_mouse_t report[REPORT_FIFO_SIZE];
+    uint8_t head;
+    uint8_t count;
+} mouse_fifo;
+#endif
+
+#ifdef EXTRAKEY_ENABLE
+static struct {
+    report_extra_t report[REPORT_FIFO_SIZE];
+    uint8_t head;
+    uint8_t count;
+} extra_fifo;
+#endif
+
+static bool report_has_key(report_keyboard_t *report, uint8_t key)
+{
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] == key) return true;
+    }
+    return false;
+}
+
+/* Whether 'next' can replace 'last' which follows 'prev' without losing any
+ * change of 'last', that is, host sees every change of keys anyway. */
+static bool keyboard_report_coalescable(report_keyboard_t *prev, report_keyboard_t *last, report_keyboard_t *next)
+{
+#ifdef NKRO_ENABLE
+    if (keyboard_protocol && keyboard_nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_SIZE; i++) {
+            if ((next->raw[i] ^ last->raw[i]) & (last->raw[i] ^ prev->raw[i])) return false;
+        }
+        return true;
+    }
+#endif
+    if ((next->mods ^ last->mods) & (last->mods ^ prev->mods)) return false;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        uint8_t key = last->keys[i];
+        // pressed in 'last' and released in 'next'
+        if (key && !report_has_key(prev, key) && !report_has_key(next, key)) return false;
+        key = prev->keys[i];
+        // released in 'last' and pressed again in 'next'
+        if (key && !report_has_key(last, key) && report_has_key(next, key)) return false;
+    }
+    return true;
+}
+
+static void keyboard_fifo_put(report_keyboard_t *report)
+{
+    if (keyboard_fifo.count) {
+        report_keyboard_t *last = &keyboard_fifo.report[FIFO_LAST(keyboard_fifo)];
+        report_keyboard_t *prev = (keyboard_fifo.count > 1) ?
+            &keyboard_fifo.report[(keyboard_fifo.head - 2) & FIFO_MASK] : &keyboard_report_sent;
+        if (keyboard_report_coalescable(prev, last, report)) {
+            *last = *report;
+            lufa_report_coalesced++;
+            return;
+        }
+        if (keyboard_fifo.count == REPORT_FIFO_SIZE) {
+            *last = *report;
+            lufa_report_dropped++;
+            return;
+        }
+    }
+    keyboard_fifo.report[keyboard_fifo.head] = *report;
+    keyboard_fifo.head = (keyboard_fifo.head + 1) & FIFO_MASK;
+    keyboard_fifo.count++;
+}
+
+#ifdef MOUSE_ENABLE
+static void mouse_fifo_put(report_mouse_t *report)
+{
+    if (mouse_fifo.count == REPORT_FIFO_SIZE) {
+        mouse_fifo.report[FIFO_LAST(mouse_fifo)] = *report;
+        lufa_report_dropped++;
+        return;
+    }
+    mouse_fifo.report[mouse_fifo.head] = *report;
+    mouse_fifo.head = (mouse_fifo.head + 1) & FIFO_MASK;
+    mouse_fifo.count++;
+}
+#endif
+
+#ifdef EXTRAKEY_ENABLE
+static void extra_fifo_put(uint8_t report_id, uint16_t usage)
+{
+    report_extra_t r = {
+        .report_id = report_id,
+        .usage = usage
+    };
+    if (extra_fifo.count == REPORT_FIFO_SIZE) {
+        extra_fifo.report[FIFO_LAST(extra_fifo)] = r;
+        lufa_report_dropped++;
+        return;
+    }
+    extra_fifo.report[extra_fifo.head] = r;
+    extra_fifo.head = (extra_fifo.head + 1) & FIFO_MASK;
+    extra_fifo.count++;
+}
+#endif
+
+static void report_fifo_clear(void)
+{
+    keyboard_fifo.count = 0;
+#ifdef MOUSE_ENABLE
+    mouse_fifo.count = 0;
+#endif
+#ifdef EXTRAKEY_ENABLE
+    extra_fifo.count = 0;
+#endif
+}
+
+/* Write oldest report of each FIFO if endpoint bank is free, never waits.
+ * Call with interrupt disabled or from USB interrupt. */
+static void report_fifo_flush(void)
+{
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return;
+
+    uint8_t ep = Endpoint_GetCurrentEndpoint();
+
+    if (keyboard_fifo.count) {
+        uint8_t size = KEYBOARD_EPSIZE;
+#ifdef NKRO_ENABLE
+        if (keyboard_protocol && keyboard_nkro) {
+            Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
+            size = NKRO_EPSIZE;
+        }
+        else
+#endif
+        {
+            Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
+        }
+        if (Endpoint_IsReadWriteAllowed()) {
+            report_keyboard_t *report = &keyboard_fifo.report[FIFO_FIRST(keyboard_fifo)];
+            Endpoint_Write_Stream_LE(report, size, NULL);
+            Endpoint_ClearIN();
+            keyboard_report_sent = *report;
+            keyboard_fifo.count--;
+        }
+    }
+
+#ifdef MOUSE_ENABLE
+    if (mouse_fifo.count) {
+        Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
+        if (Endpoint_IsReadWriteAllowed()) {
+            Endpoint_Write_Stream_LE(&mouse_fifo.report[FIFO_FIRST(mouse_fifo)], sizeof(report_mouse_t), NULL);
+            Endpoint_ClearIN();
+            mouse_fifo.count--;
+        }
+    }
+#endif
+
+#ifdef EXTRAKEY_ENABLE
+    if (extra_fifo.count) {
+        Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
+        if (Endpoint_IsReadWriteAllowed()) {
+            Endpoint_Write_Stream_LE(&extra_fifo.report[FIFO_FIRST(extra_fifo)], sizeof(report_extra_t), NULL);
+            Endpoint_ClearIN();
+            extra_fifo.count--;
+        }
+    }
+#endif
+
+    Endpoint_SelectEndpoint(ep);
+}
+
+
 /*******************************************************************************
  * Console
  ******************************************************************************/
@@ -187,6 +384,7 @@ void EVENT_USB_Device_Reset(void)
 #ifdef LUFA_DEBUG
     print("[R]");
 #endif
+    report_fifo_clear();
 }
 
 void EVENT_USB_Device_Suspend()
@@ -210,10 +408,14 @@ static bool console_flush = false;
 #define CONSOLE_FLUSH_SET(b)   do { \
     uint8_t sreg = SREG; cli(); console_flush = b; SREG = sreg; \
 } while (0)
+#endif
 
 // called every 1ms
 void EVENT_USB_Device_StartOfFrame(void)
 {
+    report_fifo_flush();
+
+#ifdef CONSOLE_ENABLE
     static uint8_t count;
     if (++count % 50) return;
     count = 0;
@@ -221,8 +423,8 @@ void EVENT_USB_Device_StartOfFrame(void)
     if (!console_flush) return;
     Console_Task();
     console_flush = false;
-}
 #endif
+}
 
 /** Event handler for the USB_ConfigurationChanged event.
  * This is fired when the host sets the current configuration of the USB device after enumeration.
@@ -237,6 +439,8 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 #endif
     bool ConfigSuccess = true;
 
+    report_fifo_clear();
+
     /* Setup Keyboard HID Report Endpoints */
     ConfigSuccess &= ENDPOINT_CONFIG(KEYBOARD_IN_EPNUM, EP_TYPE_INTERRUPT, ENDPOINT_DIR_IN,
                                      KEYBOARD_EPSIZE, ENDPOINT_BANK_SINGLE);
@@ -419,107 +623,56 @@ static uint8_t keyboard_leds(void)
 
 static void send_keyboard(report_keyboard_t *report)
 {
-    uint8_t timeout = 255;
-
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
-    /* Select the Keyboard Report Endpoint */
-#ifdef NKRO_ENABLE
-    if (keyboard_protocol && keyboard_nkro) {
-        /* Report protocol - NKRO */
-        Endpoint_SelectEndpoint(NKRO_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 1ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(8);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, NKRO_EPSIZE, NULL);
-    }
-    else
-#endif
-    {
-        /* Boot protocol */
-        Endpoint_SelectEndpoint(KEYBOARD_IN_EPNUM);
-
-        /* Check if write ready for a polling interval around 10ms */
-        while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-        if (!Endpoint_IsReadWriteAllowed()) return;
-
-        /* Write Keyboard Report Data */
-        Endpoint_Write_Stream_LE(report, KEYBOARD_EPSIZE, NULL);
-    }
-
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
-
-    keyboard_report_sent = *report;
+    uint8_t sreg = SREG;
+    cli();
+    keyboard_fifo_put(report);
+    report_fifo_flush();
+    SREG = sreg;
 }
 
 static void send_mouse(report_mouse_t *report)
 {
 #ifdef MOUSE_ENABLE
-    uint8_t timeout = 255;
-
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
-    /* Select the Mouse Report Endpoint */
-    Endpoint_SelectEndpoint(MOUSE_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    /* Write Mouse Report Data */
-    Endpoint_Write_Stream_LE(report, sizeof(report_mouse_t), NULL);
-
-    /* Finalize the stream transfer to send the last packet */
-    Endpoint_ClearIN();
+    uint8_t sreg = SREG;
+    cli();
+    mouse_fifo_put(report);
+    report_fifo_flush();
+    SREG = sreg;
 #endif
 }
 
 static void send_system(uint16_t data)
 {
-    uint8_t timeout = 255;
-
+#ifdef EXTRAKEY_ENABLE
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
-    report_extra_t r = {
-        .report_id = REPORT_ID_SYSTEM,
-        .usage = data
-    };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    uint8_t sreg = SREG;
+    cli();
+    extra_fifo_put(REPORT_ID_SYSTEM, data);
+    report_fifo_flush();
+    SREG = sreg;
+#endif
 }
 
 static void send_consumer(uint16_t data)
 {
-    uint8_t timeout = 255;
-
+#ifdef EXTRAKEY_ENABLE
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
-    report_extra_t r = {
-        .report_id = REPORT_ID_CONSUMER,
-        .usage = data
-    };
-    Endpoint_SelectEndpoint(EXTRAKEY_IN_EPNUM);
-
-    /* Check if write ready for a polling interval around 10ms */
-    while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
-    if (!Endpoint_IsReadWriteAllowed()) return;
-
-    Endpoint_Write_Stream_LE(&r, sizeof(report_extra_t), NULL);
-    Endpoint_ClearIN();
+    uint8_t sreg = SREG;
+    cli();
+    extra_fifo_put(REPORT_ID_CONSUMER, data);
+    report_fifo_flush();
+    SREG = sreg;
+#endif
 }
 
 
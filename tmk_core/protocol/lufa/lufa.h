@@ -56,6 +56,10 @@ extern "C" {
 
 extern host_driver_t lufa_driver;
 
+/* number of reports lost or merged in report FIFO */
+extern uint16_t lufa_report_dropped;
+extern uint16_t lufa_report_coalesced;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,9 @@
+NATIVE_DIR = protocol/native
+
+OPT_DEFS += -DPROTOCOL_NATIVE
+
+SRC +=	$(NATIVE_DIR)/native.c \
+	$(NATIVE_DIR)/matrix.c
+
+# Search Path
+VPATH += $(TMK_DIR)/$(NATIVE_DIR)
@@ -0,0 +1,47 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+#include "native.h"
+
+
+/* Simulated matrix
+ *
+ * Switch state is written directly by the simulator; no debounce and no
+ * scan delay so that matrix_scan() shows an edge at the exact virtual time.
+ */
+static matrix_row_t matrix[MATRIX_ROWS];
+
+
+void native_matrix_set(uint8_t row, uint8_t col, bool pressed)
+{
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS) return;
+    if (pressed) {
+        matrix[row] |= ((matrix_row_t)1<<col);
+    } else {
+        matrix[row] &= ~((matrix_row_t)1<<col);
+    }
+}
+
+void native_matrix_clear(void)
+{
+    for (uint8_t i = 0; i < MATRIX_ROWS; i++) matrix[i] = 0;
+}
+
+void matrix_init(void)
+{
+}
+
+uint8_t matrix_scan(void)
+{
+    return 1;
+}
+
+bool matrix_is_modified(void)
+{
+    return true;
+}
+
+matrix_row_t matrix_get_row(uint8_t row)
+{
+    return matrix[row];
+}
@@ -0,0 +1,322 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keyboard.h"
+#include "matrix.h"
+#include "host.h"
+#include "host_driver.h"
+#include "timer.h"
+#include "led.h"
+#include "keyboard_record.h"
+#include "native.h"
+
+
+/* host driver */
+static uint8_t keyboard_leds(void);
+static void send_keyboard(report_keyboard_t *report);
+static void send_mouse(report_mouse_t *report);
+static void send_system(uint16_t data);
+static void send_consumer(uint16_t data);
+
+host_driver_t native_driver = {
+    keyboard_leds,
+    send_keyboard,
+    send_mouse,
+    send_system,
+    send_consumer
+};
+
+uint32_t native_scan_period = NATIVE_SCAN_PERIOD;
+
+/* 0: Boot Protocol, 1: Report Protocol(default) as host sets */
+uint8_t keyboard_protocol = 1;
+/* idle rate as host sets with SET_IDLE, 4ms unit */
+uint8_t keyboard_idle = 0;
+
+static uint8_t leds = 0;
+static uint32_t scan_count = 0;
+
+static native_report_t report_log[NATIVE_REPORT_LOG_SIZE];
+static uint16_t report_count = 0;
+static uint16_t report_dropped = 0;
+
+/* trace being replayed */
+static const native_event_t *trace_p = NULL;
+static uint16_t trace_len = 0;
+
+
+void native_init(void)
+{
+    timer_clear();
+    native_matrix_clear();
+    native_report_clear();
+    leds = 0;
+    keyboard_protocol = 1;
+    keyboard_idle = 0;
+    scan_count = 0;
+    trace_p = NULL;
+    trace_len = 0;
+
+    keyboard_setup();
+    keyboard_init();
+    host_set_driver(&native_driver);
+}
+
+/* apply events due by now to matrix */
+static void trace_apply(void)
+{
+    while (trace_len && trace_p->time <= timer_read32()) {
+        native_matrix_set(trace_p->row, trace_p->col, trace_p->pressed);
+        trace_p++;
+        trace_len--;
+    }
+}
+
+void native_task(void)
+{
+    trace_apply();
+#ifdef MATRIX_SCAN_ISR_ENABLE
+    // stands for timer ISR scanning at the same period
+    keyboard_scan();
+#endif
+    keyboard_task();
+    scan_count++;
+    timer_advance_us(native_scan_period);
+}
+
+void native_run(const native_event_t *trace, uint16_t len, uint32_t until)
+{
+    trace_p = trace;
+    trace_len = len;
+    while (timer_read32() < until) {
+        native_task();
+    }
+}
+
+uint32_t native_scan_count(void)
+{
+    return scan_count;
+}
+
+void native_set_leds(uint8_t l)
+{
+    leds = l;
+}
+
+
+/*
+ * Report log
+ */
+static native_report_t *report_new(uint8_t kind)
+{
+    if (report_count >= NATIVE_REPORT_LOG_SIZE) {
+        report_dropped++;
+        return NULL;
+    }
+    native_report_t *r = &report_log[report_count++];
+    r->time = timer_read_us();
+    r->scan = scan_count;
+    r->kind = kind;
+    return r;
+}
+
+uint16_t native_report_count(void)
+{
+    return report_count;
+}
+
+uint16_t native_report_dropped(void)
+{
+    return report_dropped;
+}
+
+const native_report_t *native_report_get(uint16_t index)
+{
+    if (index >= report_count) return NULL;
+    return &report_log[index];
+}
+
+void native_report_clear(void)
+{
+    report_count = 0;
+    report_dropped = 0;
+}
+
+void native_report_print(FILE *out, const native_report_t *r)
+{
+    fprintf(out, "%10lu %6lu ", (unsigned long)r->time, (unsigned long)r->scan);
+    switch (r->kind) {
+        case NATIVE_REPORT_KEYBOARD:
+            fprintf(out, "keyboard:");
+            for (uint8_t i = 0; i < KEYBOARD_REPORT_SIZE; i++) {
+                fprintf(out, " %02X", r->keyboard.raw[i]);
+            }
+            break;
+        case NATIVE_REPORT_MOUSE:
+            fprintf(out, "mouse: %02X %d %d %d %d", r->mouse.buttons,
+                    r->mouse.x, r->mouse.y, r->mouse.v, r->mouse.h);
+            break;
+        case NATIVE_REPORT_SYSTEM:
+            fprintf(out, "system: %04X", r->usage);
+            break;
+        case NATIVE_REPORT_CONSUMER:
+            fprintf(out, "consumer: %04X", r->usage);
+            break;
+    }
+    fprintf(out, "\n");
+}
+
+
+/*
+ * Trace file
+ */
+int native_trace_load(FILE *in, native_event_t *trace, uint16_t max)
+{
+    char line[128];
+    uint16_t n = 0;
+    while (fgets(line, sizeof(line), in)) {
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        unsigned long time;
+        unsigned int row, col;
+        char state;
+        int c = sscanf(line, "%lu %u %u %c", &time, &row, &col, &state);
+        if (c == EOF || c == 0) continue;   // blank line
+        if (c != 4 || (state != 'd' && state != 'u') ||
+                row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+            return -1;
+        }
+        if (n >= max) break;
+        trace[n++] = (native_event_t){
+            .time = time,
+            .row = row,
+            .col = col,
+            .pressed = (state == 'd')
+        };
+    }
+    return n;
+}
+
+int native_record_load(FILE *in, native_event_t *trace, uint16_t max, bool events)
+{
+    char line[128];
+    unsigned int rows = 0, width = 0, len = 0;
+    unsigned long base = 0;
+    bool header = false;
+    while (!header && fgets(line, sizeof(line), in)) {
+        char *p = strstr(line, "record:");
+        header = p && sscanf(p, "record: %u %u %lx %u", &rows, &width, &base, &len) == 4;
+    }
+    if (!header || rows != MATRIX_ROWS || width != sizeof(matrix_row_t)) {
+        return -1;
+    }
+
+    uint8_t *buf = malloc(len + 1);
+    unsigned int size = 0;
+    while (size < len && fgets(line, sizeof(line), in)) {
+        char *p = strchr(line, ':');
+        if (!p) continue;
+        unsigned int b;
+        for (p++; size < len && sscanf(p, "%2x", &b) == 1; p += 2) {
+            buf[size++] = b;
+        }
+    }
+    if (size < len) {
+        free(buf);
+        return -1;
+    }
+
+    matrix_row_t rows_prev[MATRIX_ROWS] = {};
+    uint32_t time = base;
+    uint16_t n = 0;
+    unsigned int i = 0;
+    while (i < size && n < max) {
+        uint8_t tag = buf[i++];
+        uint32_t zz = 0;
+        uint8_t shift = 0;
+        do {
+            zz |= (uint32_t)(buf[i] & 0x7F) << shift;
+            shift += 7;
+        } while (buf[i++] & 0x80 && i < size);
+        time += (int32_t)((zz >> 1) ^ -(zz & 1));
+        // events stamped before base are replayed at start
+        uint32_t t = ((int32_t)(time - base) < 0) ? 0 : time - base;
+
+        if (tag & RECORD_TAG_EVENT) {
+            if (i + 2 > size) break;
+            uint8_t row = buf[i], col = buf[i + 1];
+            i += 2;
+            if (!events) continue;
+            if (row >= MATRIX_ROWS || col >= MATRIX_COLS) break;
+            trace[n++] = (native_event_t){
+                .time = t, .row = row, .col = col,
+                .pressed = (tag & RECORD_TAG_PRESSED)
+            };
+        } else {
+            if (i + sizeof(matrix_row_t) > size) break;
+            uint8_t row = tag & RECORD_TAG_ROW;
+            matrix_row_t bits = 0;
+            for (uint8_t k = 0; k < sizeof(matrix_row_t); k++) {
+                bits |= (matrix_row_t)buf[i++] << (k * 8);
+            }
+            if (events) continue;
+            if (row >= MATRIX_ROWS) break;
+            matrix_row_t change = bits ^ rows_prev[row];
+            rows_prev[row] = bits;
+            for (uint8_t c = 0; c < MATRIX_COLS && n < max; c++) {
+                if (!(change & ((matrix_row_t)1<<c))) continue;
+                trace[n++] = (native_event_t){
+                    .time = t, .row = row, .col = c,
+                    .pressed = (bits & ((matrix_row_t)1<<c))
+                };
+            }
+        }
+    }
+    bool ok = (i == size || n >= max);
+    free(buf);
+    return ok ? n : -1;
+}
+
+
+/*
+ * Host driver
+ */
+static uint8_t keyboard_leds(void)
+{
+    return leds;
+}
+
+static void send_keyboard(report_keyboard_t *report)
+{
+    native_report_t *r = report_new(NATIVE_REPORT_KEYBOARD);
+    if (r) r->keyboard = *report;
+}
+
+static void send_mouse(report_mouse_t *report)
+{
+    native_report_t *r = report_new(NATIVE_REPORT_MOUSE);
+    if (r) r->mouse = *report;
+}
+
+static void send_system(uint16_t data)
+{
+    native_report_t *r = report_new(NATIVE_REPORT_SYSTEM);
+    if (r) r->usage = data;
+}
+
+static void send_consumer(uint16_t data)
+{
+    native_report_t *r = report_new(NATIVE_REPORT_CONSUMER);
+    if (r) r->usage = data;
+}
+
+
+/* no LED on host */
+__attribute__ ((weak))
+void led_set(uint8_t usb_led)
+{
+    (void)usb_led;
+}
@@ -0,0 +1,107 @@
+/*
+ * Host-native simulation of keyboard
+ *
+ * Builds tmk_core on a PC with virtual timer, simulated matrix and a host
+ * driver which records every report with virtual timestamp. Key events are
+ * fed from scripted traces so that behaviour and latency of keyboard_task()
+ * can be checked without hardware.
+ */
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "report.h"
+#include "host_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size of report log */
+#ifndef NATIVE_REPORT_LOG_SIZE
+#define NATIVE_REPORT_LOG_SIZE  1024
+#endif
+
+/* scan period(us) which a keyboard_task() call takes in virtual time */
+#ifndef NATIVE_SCAN_PERIOD
+#define NATIVE_SCAN_PERIOD      1000
+#endif
+
+
+/* scripted key event */
+typedef struct {
+    uint32_t time;      /* ms */
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+} native_event_t;
+
+/* report captured from host driver */
+enum native_report_kind {
+    NATIVE_REPORT_KEYBOARD,
+    NATIVE_REPORT_MOUSE,
+    NATIVE_REPORT_SYSTEM,
+    NATIVE_REPORT_CONSUMER,
+};
+
+typedef struct {
+    uint32_t time;      /* virtual time(us) */
+    uint32_t scan;      /* count of keyboard_task() when sent */
+    uint8_t  kind;
+    union {
+        report_keyboard_t keyboard;
+        report_mouse_t    mouse;
+        uint16_t          usage;
+    };
+} native_report_t;
+
+
+extern host_driver_t native_driver;
+extern uint32_t native_scan_period;
+
+
+/* reset clock, matrix, report log and initialize keyboard */
+void native_init(void);
+/* run one keyboard_task() and advance virtual clock by scan period */
+void native_task(void);
+/* replay trace until virtual time 'until'(ms) */
+void native_run(const native_event_t *trace, uint16_t len, uint32_t until);
+/* count of keyboard_task() calls */
+uint32_t native_scan_count(void);
+
+/* simulated matrix */
+void native_matrix_set(uint8_t row, uint8_t col, bool pressed);
+void native_matrix_clear(void);
+
+/* host LED state returned to keyboard */
+void native_set_leds(uint8_t leds);
+
+/* report log */
+uint16_t native_report_count(void);
+uint16_t native_report_dropped(void);
+const native_report_t *native_report_get(uint16_t index);
+void native_report_clear(void);
+void native_report_print(FILE *out, const native_report_t *report);
+
+/* Trace file
+ *   one event per line: <time(ms)> <row> <col> <d|u>
+ *   '#' starts comment
+ * returns number of events read, or -1 on syntax error
+ */
+int native_trace_load(FILE *in, native_event_t *trace, uint16_t max);
+
+/* Dump of keyboard_record.h
+ *   reads first dump in console log, other lines are skipped
+ *   trace is of row changes, or of action_exec() inputs when 'events'
+ *   time is ms since base time of dump
+ * returns number of events read, or -1 on syntax error or matrix mismatch
+ */
+int native_record_load(FILE *in, native_event_t *trace, uint16_t max, bool events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -37,6 +37,8 @@ ARDUINO_CORES_SRC = \
 # HID parser
 #
 SRC += $(USB_HID_DIR)/parser.cpp
+SRC += $(USB_HID_DIR)/report_desc.c
+SRC += $(USB_HID_DIR)/hid_keyboard.cpp
 
 # replace arduino/CDC.cpp
 SRC += $(USB_HID_DIR)/override_Serial.cpp
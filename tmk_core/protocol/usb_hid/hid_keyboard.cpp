@@ -0,0 +1,111 @@
+#include "hid_keyboard.h"
+#include "report_desc.h"
+
+#include "debug.h"
+
+
+/* feeds report descriptor to parser as it is received */
+class ReportDescReader : public USBReadParser
+{
+public:
+    hid_desc_parser_t desc;
+    ReportDescReader(hid_kbd_plan_t *plan) { hid_desc_init(&desc, plan); }
+    void Parse(const uint16_t len, const uint8_t *pbuf, const uint16_t &offset) {
+        hid_desc_feed(&desc, pbuf, len);
+    }
+};
+
+
+HIDKeyboard::HIDKeyboard(USB *p, KBDReportParser *prs) :
+HIDBoot<HID_PROTOCOL_KEYBOARD>(p),
+parser(prs),
+ifaceNum(0),
+epAddr(0),
+maxPktSize(0),
+interval(0),
+nextPollTime(0),
+reportProtocol(false)
+{
+    SetReportParser(0, prs);
+}
+
+uint8_t HIDKeyboard::Init(uint8_t parent, uint8_t port, bool lowspeed)
+{
+    if (bAddress) return USB_ERROR_CLASS_INSTANCE_ALREADY_IN_USE;
+
+    ifaceNum = epAddr = maxPktSize = interval = 0;
+    uint8_t rcode = HIDBoot<HID_PROTOCOL_KEYBOARD>::Init(parent, port, lowspeed);
+    if (rcode) return rcode;
+
+    // HIDBoot has set boot protocol
+    hid_kbd_plan_boot(&parser->plan);
+    hid_kbd_plan_t plan;
+    ReportDescReader reader(&plan);
+    rcode = GetReportDescr(ifaceNum, &reader);
+    if (rcode || !hid_desc_done(&reader.desc)) {
+        dprintf("report desc %d: unknown(%02X)\n", bAddress, rcode);
+        return 0;
+    }
+    dprintf("report desc %d: fields:%d rollover:%d id:%d\n", bAddress,
+            plan.nfields, hid_kbd_rollover(&plan), plan.has_report_id);
+    if (hid_kbd_rollover(&plan) <= hid_kbd_rollover(&parser->plan)) return 0;
+
+    rcode = SetProtocol(ifaceNum, HID_RPT_PROTOCOL);
+    if (rcode) {
+        dprintf("report protocol %d: failed(%02X)\n", bAddress, rcode);
+        return 0;
+    }
+    parser->plan = plan;
+    nextPollTime = millis();
+    reportProtocol = true;
+    return 0;
+}
+
+uint8_t HIDKeyboard::Release()
+{
+    reportProtocol = false;
+    return HIDBoot<HID_PROTOCOL_KEYBOARD>::Release();
+}
+
+uint8_t HIDKeyboard::Poll()
+{
+    if (!reportProtocol) return HIDBoot<HID_PROTOCOL_KEYBOARD>::Poll();
+
+    // HIDBoot reads up to 16 bytes, NKRO report can be longer
+    if (!isReady() || (long)(millis() - nextPollTime) < 0L) return 0;
+    nextPollTime = millis() + interval;
+
+    uint8_t buf[HID_KEYBOARD_REPORT_MAX];
+    uint16_t read = (maxPktSize < sizeof(buf)) ? maxPktSize : sizeof(buf);
+    uint8_t rcode = pUsb->inTransfer(bAddress, epAddr, &read, buf);
+    if (!rcode && read) {
+        parser->Parse(this, parser->plan.has_report_id, read, buf);
+    }
+    return rcode;
+}
+
+void HIDKeyboard::EndpointXtract(uint8_t conf, uint8_t iface, uint8_t alt, uint8_t proto, const USB_ENDPOINT_DESCRIPTOR *pep)
+{
+    // first interrupt IN endpoint which HIDBoot takes as well
+    if (!epAddr && (pep->bmAttributes & 0x03) == 3 && (pep->bEndpointAddress & 0x80) == 0x80) {
+        ifaceNum = iface;
+        epAddr = pep->bEndpointAddress & 0x0F;
+        maxPktSize = (uint8_t)pep->wMaxPacketSize;
+        interval = pep->bInterval;
+    }
+    HIDBoot<HID_PROTOCOL_KEYBOARD>::EndpointXtract(conf, iface, alt, proto, pep);
+}
+
+uint8_t HIDKeyboard::SetLed(uint8_t usb_led)
+{
+    // address 0 may be device in enumeration
+    if (!isReady()) return 0;
+
+    const hid_kbd_plan_t *plan = &parser->plan;
+    if (reportProtocol && plan->has_report_id) {
+        if (!plan->has_led) return 0;
+        uint8_t buf[2] = { plan->led_report_id, usb_led };
+        return SetReport(0, ifaceNum, 2, plan->led_report_id, 2, buf);
+    }
+    return SetReport(0, ifaceNum, 2, 0, 1, &usb_led);
+}
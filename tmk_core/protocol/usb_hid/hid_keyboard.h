@@ -0,0 +1,45 @@
+#ifndef HID_KEYBOARD_H
+#define HID_KEYBOARD_H
+
+#include "Usb.h"
+#include "hid.h"
+#include "hidboot.h"
+#include "parser.h"
+
+
+/* largest report read in report protocol, max packet of full speed interrupt */
+#define HID_KEYBOARD_REPORT_MAX 64
+
+/*
+ * Boot keyboard interface driven in report protocol
+ *
+ * Report descriptor is parsed into plan of parser at enumeration. Keyboard
+ * is switched to report protocol when the plan can report more keys than
+ * boot protocol, NKRO bitmap for example, otherwise it stays in boot
+ * protocol as HIDBoot does.
+ */
+class HIDKeyboard : public HIDBoot<HID_PROTOCOL_KEYBOARD>
+{
+    KBDReportParser *parser;
+    // interrupt IN endpoint of keyboard interface
+    uint8_t ifaceNum;
+    uint8_t epAddr;
+    uint8_t maxPktSize;
+    uint8_t interval;
+    uint32_t nextPollTime;
+    bool reportProtocol;
+
+public:
+    HIDKeyboard(USB *p, KBDReportParser *prs);
+
+    uint8_t Init(uint8_t parent, uint8_t port, bool lowspeed);
+    uint8_t Release();
+    uint8_t Poll();
+    virtual void EndpointXtract(uint8_t conf, uint8_t iface, uint8_t alt, uint8_t proto, const USB_ENDPOINT_DESCRIPTOR *ep);
+
+    /* sends LED output report, with report ID in report protocol */
+    uint8_t SetLed(uint8_t usb_led);
+    bool isReportProtocol() { return reportProtocol; };
+};
+
+#endif
@@ -2,6 +2,7 @@
  * To keep Timer0 for common/timer.c override arduino/wiring.c.
  */
 #define __DELAY_BACKWARD_COMPATIBLE__
+#include <avr/io.h>
 #include <util/delay.h>
 #include "common/timer.h"
 #include "Arduino.h"
@@ -15,9 +16,23 @@ unsigned long micros()
 {
     return timer_read32() * 1000UL;
 }
+/* called repeatedly while delay() waits, see usb_hid.h */
+__attribute__ ((weak))
+void yield(void)
+{
+}
 void delay(unsigned long ms)
 {
-    _delay_ms(ms);
+    // timer doesn't run before sei()
+    if (!(SREG & (1<<SREG_I))) {
+        _delay_ms(ms);
+        return;
+    }
+    // at least ms as timer may tick soon after start
+    uint32_t start = timer_read32();
+    while (timer_elapsed32(start) <= ms) {
+        yield();
+    }
 }
 void delayMicroseconds(unsigned int us)
 {
@@ -4,14 +4,36 @@
 #include "debug.h"
 
 
+KBDReportParser::KBDReportParser()
+{
+    ::memset(keys, 0, sizeof(keys));
+    hid_kbd_plan_boot(&plan);
+}
+
 void KBDReportParser::Parse(HID *hid, bool is_rpt_id, uint8_t len, uint8_t *buf)
 {
-    ::memcpy(&report, buf, sizeof(report_keyboard_t));
+    uint8_t prev[HID_KBD_BITMAP_SIZE];
+    ::memcpy(prev, keys, sizeof(keys));
     time_stamp = millis();
 
-    dprintf("input %d:  %02X %02X", hid->GetAddress(), report.mods, report.reserved);
-    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
-        dprintf(" %02X", report.keys[i]);
+    dprintf("input %d:", hid->GetAddress());
+    for (uint8_t i = 0; i < len; i++) {
+        dprintf(" %02X", buf[i]);
     }
     dprint("\r\n");
+
+    // other report than keyboard, or keys are unknown on rollover error
+    if (!hid_kbd_decode(&plan, buf, len, keys)) return;
+
+    for (uint8_t i = 0; i < HID_KBD_BITMAP_SIZE; i++) {
+        uint8_t change = prev[i] ^ keys[i];
+        for (uint8_t j = 0; change; j++, change >>= 1) {
+            if (change & 1) KeyChange(i * 8 + j, keys[i] & (1<<j));
+        }
+    }
+}
+
+bool KBDReportParser::IsPressed(uint8_t code)
+{
+    return keys[code >> 3] & (1<<(code & 7));
 }
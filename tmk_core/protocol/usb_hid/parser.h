@@ -3,13 +3,23 @@
 
 #include "hid.h"
 #include "report.h"
+#include "report_desc.h"
 
 class KBDReportParser : public HIDReportParser
 {
 public:
-    report_keyboard_t report;
+    /* keys down in last report, bitmap of keycodes, see report_desc.h */
+    uint8_t keys[HID_KBD_BITMAP_SIZE];
+    /* fields of report, boot protocol unless set from report descriptor */
+    hid_kbd_plan_t plan;
     uint16_t time_stamp;
+    KBDReportParser();
     virtual void Parse(HID *hid, bool is_rpt_id, uint8_t len, uint8_t *buf);
+    /* whether key is down in last report, modifiers are KC_LCTRL...KC_RGUI */
+    bool IsPressed(uint8_t code);
+protected:
+    /* called with each key changed from previous report */
+    virtual void KeyChange(uint8_t code, bool pressed) {}
 };
 
 #endif
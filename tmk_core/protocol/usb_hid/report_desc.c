@@ -0,0 +1,355 @@
+#include <string.h>
+#include "report_desc.h"
+
+
+#define PAGE_KEYBOARD   0x07
+#define PAGE_LED        0x08
+
+/* first modifier of Keyboard page */
+#define USAGE_LEFT_CONTROL  0xE0
+
+/* item tag and type of prefix, size bits masked */
+#define ITEM_INPUT          0x80
+#define ITEM_OUTPUT         0x90
+#define ITEM_FEATURE        0xB0
+#define ITEM_COLLECTION     0xA0
+#define ITEM_END_COLLECTION 0xC0
+#define ITEM_USAGE_PAGE     0x04
+#define ITEM_LOGICAL_MIN    0x14
+#define ITEM_LOGICAL_MAX    0x24
+#define ITEM_REPORT_SIZE    0x74
+#define ITEM_REPORT_ID      0x84
+#define ITEM_REPORT_COUNT   0x94
+#define ITEM_PUSH           0xA4
+#define ITEM_POP            0xB4
+#define ITEM_USAGE          0x08
+#define ITEM_USAGE_MIN      0x18
+#define ITEM_USAGE_MAX      0x28
+#define ITEM_LONG           0xFE
+
+/* main item data bits */
+#define MAIN_CONSTANT       0x01
+#define MAIN_VARIABLE       0x02
+
+
+/* Boot keyboard report descriptor, HID 1.11 Appendix B.1 */
+static const uint8_t boot_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02,     // modifiers
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,     // reserved
+    0x95, 0x05, 0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x05,
+    0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01,     // LED
+    0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00,     // keys
+    0xC0
+};
+
+
+static void clear_local(hid_desc_parser_t *p)
+{
+    p->has_usage = false;
+    p->usage_list = false;
+    p->usage_min = p->usage_max = 0;
+}
+
+/* usage with page, short usage takes page in effect */
+static uint32_t full_usage(hid_desc_parser_t *p, uint32_t usage, uint8_t size)
+{
+    return (size == 4) ? usage : ((uint32_t)p->global.usage_page << 16) | (usage & 0xFFFF);
+}
+
+static uint16_t *report_bits(hid_desc_parser_t *p, uint8_t id)
+{
+    for (uint8_t i = 0; i < p->nreports; i++) {
+        if (p->reports[i].id == id) return &p->reports[i].bits;
+    }
+    if (p->nreports == HID_DESC_REPORTS_MAX) {
+        p->error = true;
+        return NULL;
+    }
+    p->reports[p->nreports].id = id;
+    p->reports[p->nreports].bits = 0;
+    return &p->reports[p->nreports++].bits;
+}
+
+static void add_field(hid_desc_parser_t *p, const hid_kbd_field_t *field)
+{
+    hid_kbd_plan_t *plan = p->plan;
+    if (plan->nfields == HID_KBD_FIELDS_MAX) {
+        // keys of dropped field would never be seen
+        p->error = true;
+        return;
+    }
+    plan->fields[plan->nfields++] = *field;
+}
+
+static void input_item(hid_desc_parser_t *p, uint32_t data)
+{
+    hid_desc_global_t *g = &p->global;
+    uint16_t *bits = report_bits(p, g->report_id);
+    if (!bits) return;
+    uint16_t offset = *bits;
+    *bits += g->report_size * g->report_count;
+
+    if ((data & MAIN_CONSTANT) || !p->has_usage || p->usage_list) return;
+    if ((p->usage_min >> 16) != PAGE_KEYBOARD || (p->usage_max >> 16) != PAGE_KEYBOARD) return;
+    uint16_t umin = p->usage_min & 0xFFFF;
+    uint16_t umax = p->usage_max & 0xFFFF;
+    if (umin > 0xFF || umax < umin || g->report_count == 0) return;
+    if (umax > 0xFF) umax = 0xFF;
+
+    hid_kbd_field_t f = {
+        .report_id = g->report_id,
+        .offset = offset,
+        .size = g->report_size,
+        .usage_min = umin,
+    };
+    if (data & MAIN_VARIABLE) {
+        if (g->report_size != 1) return;
+        // usages beyond 0xFF and bits without usage are ignored
+        uint16_t n = umax - umin + 1;
+        if (n > g->report_count) n = g->report_count;
+        if (n > 0xFF) n = 0xFF;
+        f.count = n;
+        f.usage_max = umin + n - 1;
+    } else {
+        // logical maximum is taken unsigned as 0x25 0xFF is often meant 255
+        if (g->report_size == 0 || g->report_size > 8 || g->report_count > 0xFF) return;
+        if (g->logical_min < 0 || g->logical_min > 0xFF || g->logical_max < (uint32_t)g->logical_min) return;
+        if (umin + (g->logical_max - g->logical_min) < umax) {
+            umax = umin + (g->logical_max - g->logical_min);
+        }
+        f.flags = HID_FIELD_ARRAY;
+        f.count = g->report_count;
+        f.usage_max = umax;
+        f.logical_min = g->logical_min;
+    }
+    add_field(p, &f);
+}
+
+static void short_item(hid_desc_parser_t *p, uint8_t prefix, uint32_t data, uint8_t size)
+{
+    hid_desc_global_t *g = &p->global;
+    switch (prefix & 0xFC) {
+        case ITEM_INPUT:
+            input_item(p, data);
+            clear_local(p);
+            break;
+        case ITEM_OUTPUT:
+            if (!(data & MAIN_CONSTANT) && p->has_usage && (p->usage_min >> 16) == PAGE_LED) {
+                p->plan->has_led = true;
+                p->plan->led_report_id = g->report_id;
+            }
+            clear_local(p);
+            break;
+        case ITEM_FEATURE:
+        case ITEM_COLLECTION:
+        case ITEM_END_COLLECTION:
+            clear_local(p);
+            break;
+        case ITEM_USAGE_PAGE:
+            g->usage_page = data;
+            break;
+        case ITEM_LOGICAL_MIN:
+            // sign extended
+            if (size && size < 4 && (data & ((uint32_t)1 << (size * 8 - 1)))) {
+                data |= ~(((uint32_t)1 << (size * 8)) - 1);
+            }
+            g->logical_min = (int32_t)data;
+            break;
+        case ITEM_LOGICAL_MAX:
+            g->logical_max = data;
+            break;
+        case ITEM_REPORT_SIZE:
+            g->report_size = data;
+            break;
+        case ITEM_REPORT_ID:
+            g->report_id = data;
+            p->plan->has_report_id = true;
+            break;
+        case ITEM_REPORT_COUNT:
+            g->report_count = data;
+            break;
+        case ITEM_PUSH:
+            if (p->depth == HID_DESC_STACK_MAX) {
+                p->error = true;
+                break;
+            }
+            p->stack[p->depth++] = *g;
+            break;
+        case ITEM_POP:
+            if (p->depth == 0) {
+                p->error = true;
+                break;
+            }
+            *g = p->stack[--p->depth];
+            break;
+        case ITEM_USAGE: {
+            uint32_t usage = full_usage(p, data, size);
+            if (!p->has_usage) {
+                p->usage_min = p->usage_max = usage;
+                p->has_usage = true;
+            } else if (usage == p->usage_max + 1) {
+                p->usage_max = usage;
+            } else {
+                p->usage_list = true;
+            }
+            break;
+        }
+        case ITEM_USAGE_MIN:
+            p->usage_min = full_usage(p, data, size);
+            p->has_usage = true;
+            break;
+        case ITEM_USAGE_MAX:
+            p->usage_max = full_usage(p, data, size);
+            break;
+        default:
+            break;
+    }
+}
+
+void hid_desc_init(hid_desc_parser_t *parser, hid_kbd_plan_t *plan)
+{
+    memset(parser, 0, sizeof(*parser));
+    memset(plan, 0, sizeof(*plan));
+    parser->plan = plan;
+}
+
+void hid_desc_feed(hid_desc_parser_t *p, const uint8_t *buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len && !p->error; i++) {
+        uint8_t b = buf[i];
+        if (p->remain == 0 && !p->long_item) {
+            // prefix of new item
+            p->prefix = b;
+            p->data = 0;
+            p->shift = 0;
+            if (b == ITEM_LONG) {
+                p->long_item = true;
+                p->remain = 0xFFFF; // size comes next
+                continue;
+            }
+            p->remain = (b & 0x03) == 3 ? 4 : (b & 0x03);
+            if (p->remain == 0) short_item(p, b, 0, 0);
+            continue;
+        }
+        if (p->long_item) {
+            // bDataSize, bLongItemTag and data are skipped
+            if (p->remain == 0xFFFF) {
+                p->remain = b + 1;
+            } else if (--p->remain == 0) {
+                p->long_item = false;
+            }
+            continue;
+        }
+        p->data |= (uint32_t)b << p->shift;
+        p->shift += 8;
+        if (--p->remain == 0) {
+            short_item(p, p->prefix, p->data, p->shift / 8);
+        }
+    }
+}
+
+bool hid_desc_done(hid_desc_parser_t *p)
+{
+    return !p->error && p->remain == 0 && !p->long_item && p->plan->nfields;
+}
+
+void hid_kbd_plan_boot(hid_kbd_plan_t *plan)
+{
+    hid_desc_parser_t parser;
+    hid_desc_init(&parser, plan);
+    hid_desc_feed(&parser, boot_desc, sizeof(boot_desc));
+}
+
+uint16_t hid_kbd_rollover(const hid_kbd_plan_t *plan)
+{
+    uint16_t n = 0;
+    for (uint8_t i = 0; i < plan->nfields; i++) {
+        const hid_kbd_field_t *f = &plan->fields[i];
+        if ((f->flags & HID_FIELD_ARRAY) || f->usage_min < USAGE_LEFT_CONTROL) n += f->count;
+    }
+    return n;
+}
+
+
+static uint8_t get_bits(const uint8_t *data, uint16_t offset, uint8_t size)
+{
+    const uint8_t *p = data + (offset >> 3);
+    uint8_t shift = offset & 7;
+    uint16_t v = p[0] >> shift;
+    if (shift + size > 8) v |= (uint16_t)p[1] << (8 - shift);
+    return v & ((1 << size) - 1);
+}
+
+static void clear_range(uint8_t *keys, uint8_t min, uint8_t max)
+{
+    uint16_t u = min;
+    for (; u <= max && (u & 7); u++) keys[u >> 3] &= ~(1 << (u & 7));
+    for (; u + 7 <= max; u += 8) keys[u >> 3] = 0;
+    for (; u <= max; u++) keys[u >> 3] &= ~(1 << (u & 7));
+}
+
+static void set_bitmap(uint8_t *keys, const hid_kbd_field_t *f, const uint8_t *data)
+{
+    uint16_t i = 0;
+    if (!(f->offset & 7) && !(f->usage_min & 7)) {
+        // byte aligned as usual, bits are copied in bytes
+        const uint8_t *src = data + (f->offset >> 3);
+        uint8_t *dst = keys + (f->usage_min >> 3);
+        for (; i + 8 <= f->count; i += 8) *dst++ |= *src++;
+    }
+    for (; i < f->count; i++) {
+        if (get_bits(data, f->offset + i, 1)) {
+            uint8_t u = f->usage_min + i;
+            keys[u >> 3] |= 1 << (u & 7);
+        }
+    }
+}
+
+bool hid_kbd_decode(const hid_kbd_plan_t *plan, const uint8_t *report, uint8_t len, uint8_t *keys)
+{
+    uint8_t id = 0;
+    if (plan->has_report_id) {
+        if (len == 0) return false;
+        id = *report++;
+        len--;
+    }
+
+    bool found = false;
+    for (uint8_t i = 0; i < plan->nfields; i++) {
+        const hid_kbd_field_t *f = &plan->fields[i];
+        if (f->report_id != id) continue;
+        if (f->offset + (uint16_t)f->size * f->count > (uint16_t)len * 8) return false;
+        found = true;
+        if (!(f->flags & HID_FIELD_ARRAY)) continue;
+        for (uint8_t j = 0; j < f->count; j++) {
+            uint8_t v = get_bits(report, f->offset + j * f->size, f->size);
+            if (v >= f->logical_min && f->usage_min + (v - f->logical_min) == 0x01) return false;
+        }
+    }
+    if (!found) return false;
+
+    for (uint8_t i = 0; i < plan->nfields; i++) {
+        const hid_kbd_field_t *f = &plan->fields[i];
+        if (f->report_id == id) clear_range(keys, f->usage_min, f->usage_max);
+    }
+    for (uint8_t i = 0; i < plan->nfields; i++) {
+        const hid_kbd_field_t *f = &plan->fields[i];
+        if (f->report_id != id) continue;
+        if (!(f->flags & HID_FIELD_ARRAY)) {
+            set_bitmap(keys, f, report);
+            continue;
+        }
+        for (uint8_t j = 0; j < f->count; j++) {
+            uint8_t v = get_bits(report, f->offset + j * f->size, f->size);
+            if (v < f->logical_min) continue;
+            uint16_t u = f->usage_min + (v - f->logical_min);
+            if (u <= f->usage_max) keys[u >> 3] |= 1 << (u & 7);
+        }
+    }
+    // Reserved, ErrorRollOver, POSTFail and ErrorUndefined are not keys
+    keys[0] &= 0xF0;
+    return true;
+}
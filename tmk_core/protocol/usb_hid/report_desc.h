@@ -0,0 +1,116 @@
+#ifndef REPORT_DESC_H
+#define REPORT_DESC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * HID report descriptor parser for keyboard
+ *
+ * Descriptor is parsed once at enumeration into plan, list of input fields
+ * of Keyboard usage page(0x07) with bit offset in report. Reports are
+ * decoded with the plan into bitmap of 256 keycodes, bit n of byte n/8 is
+ * set while keycode n is down. Usages 0x00-0x03 are not keys and never set.
+ *
+ *   bitmap field:  one bit per usage from usage_min, modifiers and NKRO
+ *   array field:   count items of size bits, value v is down usage
+ *                  usage_min + (v - logical_min), boot 6KRO keys
+ *
+ * A report replaces state of all usages covered by its fields. Reports with
+ * ErrorRollOver in array are discarded as keys are unknown.
+ */
+#ifndef HID_KBD_FIELDS_MAX
+#define HID_KBD_FIELDS_MAX  4
+#endif
+
+/* report IDs whose input bit offsets are tracked during parse */
+#ifndef HID_DESC_REPORTS_MAX
+#define HID_DESC_REPORTS_MAX    8
+#endif
+
+#define HID_DESC_STACK_MAX  2
+
+#define HID_KBD_BITMAP_SIZE 32
+
+/* field flags */
+#define HID_FIELD_ARRAY     0x01
+
+typedef struct {
+    uint8_t  report_id;     // 0 when reports have no ID
+    uint8_t  flags;
+    uint16_t offset;        // bit offset of first item after report ID byte
+    uint8_t  size;          // bits of item, 1 in bitmap
+    uint8_t  count;         // items of array, or bits used in bitmap
+    uint8_t  usage_min;     // usage of first bit, or of logical_min
+    uint8_t  usage_max;     // last usage field can report
+    uint8_t  logical_min;   // array only
+} hid_kbd_field_t;
+
+typedef struct {
+    uint8_t nfields;
+    bool has_report_id;     // reports are prefixed with ID byte
+    bool has_led;           // output report of LED page exists
+    uint8_t led_report_id;
+    hid_kbd_field_t fields[HID_KBD_FIELDS_MAX];
+} hid_kbd_plan_t;
+
+
+/* Global items, saved by Push and restored by Pop */
+typedef struct {
+    uint16_t usage_page;
+    int32_t  logical_min;
+    uint32_t logical_max;   // unsigned, see input_item()
+    uint16_t report_size;
+    uint16_t report_count;
+    uint8_t  report_id;
+} hid_desc_global_t;
+
+/* Parser state, descriptor can be fed in pieces as it is received */
+typedef struct {
+    hid_kbd_plan_t *plan;
+    // item in progress
+    uint8_t  prefix;
+    uint16_t remain;        // bytes to read of short item, or to skip of long item
+    uint8_t  shift;
+    uint32_t data;
+    bool     long_item;
+    // item state
+    hid_desc_global_t global;
+    hid_desc_global_t stack[HID_DESC_STACK_MAX];
+    uint8_t  depth;
+    uint32_t usage_min;     // Usage Page in high 16 bits
+    uint32_t usage_max;
+    bool     has_usage;
+    bool     usage_list;    // Usages are not contiguous
+    // input bits so far of each report ID
+    struct {
+        uint8_t  id;
+        uint16_t bits;
+    } reports[HID_DESC_REPORTS_MAX];
+    uint8_t  nreports;
+    bool     error;
+} hid_desc_parser_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void hid_desc_init(hid_desc_parser_t *parser, hid_kbd_plan_t *plan);
+void hid_desc_feed(hid_desc_parser_t *parser, const uint8_t *buf, uint16_t len);
+/* true when descriptor is parsed without error and has keyboard fields */
+bool hid_desc_done(hid_desc_parser_t *parser);
+
+/* plan of boot protocol keyboard report */
+void hid_kbd_plan_boot(hid_kbd_plan_t *plan);
+/* keys reported at once not counting modifiers, 6 in boot protocol */
+uint16_t hid_kbd_rollover(const hid_kbd_plan_t *plan);
+/* updates keys with report, false when report is not of keyboard or keys are unknown */
+bool hid_kbd_decode(const hid_kbd_plan_t *plan, const uint8_t *report, uint8_t len, uint8_t *keys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
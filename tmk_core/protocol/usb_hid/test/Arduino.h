@@ -0,0 +1,105 @@
+/*
+ * Arduino API of host build for USB Host Shield library
+ *
+ * The library has no PC target. Its MIPS build is taken instead as it
+ * drives MAX3421E with digitalWrite()/digitalRead() and SPI.transfer()
+ * only, and those are connected to the chip model of max3421e_mock.h.
+ * Time is the virtual clock of common/native/timer.c.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef __MIPSEL__
+#define __MIPSEL__
+#endif
+
+/* PROGMEM of tmk so that the library doesn't define its own */
+#include "progmem.h"
+/* same as avrpins.h of MIPS, not used by the library */
+#define pgm_read_pointer(p) pgm_read_dword(p)
+
+
+#define HIGH    0x1
+#define LOW     0x0
+
+#define INPUT   0x0
+#define OUTPUT  0x1
+
+#define DEC     10
+#define HEX     16
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+#ifdef __cplusplus
+}
+
+
+/* debug print of library is dropped */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { (void)c; return 1; }
+    size_t print(const char *s) { size_t n = 0; while (*s) n += write(*s++); return n; }
+    size_t print(char c) { return write(c); }
+    size_t print(unsigned long n, int base = DEC) { return number(n, base); }
+    size_t print(unsigned int n, int base = DEC) { return number(n, base); }
+    size_t print(unsigned char n, int base = DEC) { return number(n, base); }
+    size_t print(long n, int base = DEC) { return (n < 0) ? write('-') + number(-n, base) : number(n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(double d, int digits = 2) { (void)digits; return number((unsigned long)d, DEC); }
+    template<typename T> size_t println(T v) { return print(v) + print("\r\n"); }
+    template<typename T> size_t println(T v, int base) { return print(v, base) + print("\r\n"); }
+    size_t println(void) { return print("\r\n"); }
+private:
+    size_t number(unsigned long n, int base) {
+        char buf[8 * sizeof(long) + 1];
+        char *p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        do {
+            uint8_t d = n % base;
+            *--p = (d < 10) ? '0' + d : 'A' + d - 10;
+            n /= base;
+        } while (n);
+        return print(p);
+    }
+};
+
+extern Print Serial;
+
+
+/* SPI master, MAX3421E is the only slave */
+class SPIClass
+{
+public:
+    void begin(void) {}
+    void setClockDivider(uint8_t div) { (void)div; }
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "Usb.h"
+#include "keycode.h"
+#include "timer.h"
+#include "max3421e_mock.h"
+#include "usb_device_mock.h"
+#include "native.h"
+
+
+/*
+ * Enumeration time and per-report cost of USB to USB converter
+ *
+ * Enumeration is measured in virtual time from plugging to the keyboard
+ * ready, with SPI traffic to MAX3421E. Per-report cost is taken against
+ * idle loop of the same scans: SPI bytes with virtual time they take on
+ * target, see MAX3421E_MOCK_SPI_NS, and host CPU time of the whole path
+ * through usb_usb.cpp, parser.cpp and keyboard_task().
+ *
+ *   usage: bench [reports]
+ */
+/* best of repeats is taken to shed noise of host */
+#define BENCH_REPEAT    5
+
+/* LED twinkle of HIDBoot at enumeration */
+#define TWINKLE_REPORTS 6
+
+/* matrix is of USB keyboards, simulated matrix of native.c is not used */
+void native_matrix_set(uint8_t row, uint8_t col, bool pressed) {}
+void native_matrix_clear(void) {}
+
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run(uint32_t ms)
+{
+    uint32_t start = timer_read32();
+    while (timer_elapsed32(start) < ms) {
+        native_task();
+    }
+}
+
+static bool ready(UsbMockKeyboard *kbd)
+{
+    return kbd->configuration && kbd->led_reports > TWINKLE_REPORTS;
+}
+
+
+/*
+ * Enumeration
+ */
+static void enumeration(const char *name, UsbMockDevice *root, UsbMockKeyboard *kbd1, UsbMockKeyboard *kbd2)
+{
+    max3421e_mock_stat_t stat = *max3421e_mock_stat();
+    uint32_t start = timer_read32();
+    max3421e_mock_attach(root);
+    while (!ready(kbd1) || (kbd2 && !ready(kbd2))) {
+        if (timer_elapsed32(start) > 30000) {
+            printf("%-20s timeout\n", name);
+            break;
+        }
+        native_task();
+    }
+    uint32_t ms = timer_elapsed32(start);
+    const max3421e_mock_stat_t *s = max3421e_mock_stat();
+    printf("%-20s %8lu %10lu %10lu %8lu\n", name, (unsigned long)ms,
+            (unsigned long)(s->spi_bytes - stat.spi_bytes),
+            (unsigned long)(s->transfers - stat.transfers),
+            (unsigned long)(s->naks - stat.naks));
+
+    max3421e_mock_attach(NULL);
+    run(100);
+}
+
+
+/*
+ * Per-report cost
+ */
+typedef struct {
+    uint64_t ns;
+    uint32_t spi_bytes;
+    uint32_t reports;
+} cost_t;
+
+/* runs scans, with key toggled whenever its last report is taken if 'type' */
+static cost_t scan(UsbMockKeyboard *kbd, uint32_t scans, bool type)
+{
+    cost_t c = { 0, max3421e_mock_stat()->spi_bytes, 0 };
+    bool on = false;
+    native_report_clear();
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < scans; i++) {
+        if (type && !kbd->queued()) {
+            on = !on;
+            if (on) kbd->press(KC_A); else kbd->release(KC_A);
+            c.reports++;
+        }
+        native_task();
+        if (native_report_count() > NATIVE_REPORT_LOG_SIZE / 2) native_report_clear();
+    }
+    c.ns = now_ns() - start;
+    c.spi_bytes = max3421e_mock_stat()->spi_bytes - c.spi_bytes;
+    c.reports -= kbd->queued();
+
+    // leave key released
+    if (on) kbd->release(KC_A);
+    run(50);
+    return c;
+}
+
+static void report_cost(const char *name, UsbMockKeyboard *kbd, uint32_t reports)
+{
+    max3421e_mock_attach(kbd);
+    while (!ready(kbd)) native_task();
+    run(100);
+
+    // scans which take the reports, a report per interval of endpoint
+    uint32_t scans = reports * (10000 / native_scan_period);
+    cost_t idle = scan(kbd, scans, false);
+    cost_t busy = scan(kbd, scans, true);
+    for (uint8_t i = 1; i < BENCH_REPEAT; i++) {
+        cost_t c = scan(kbd, scans, false);
+        if (c.ns < idle.ns) idle = c;
+        c = scan(kbd, scans, true);
+        if (c.ns < busy.ns) busy = c;
+    }
+
+    double spi = (double)((int32_t)(busy.spi_bytes - idle.spi_bytes)) / busy.reports;
+    double ns = (double)((int64_t)(busy.ns - idle.ns)) / busy.reports;
+    printf("%-20s %8lu %10.1f %10.1f %10.1f\n", name, (unsigned long)busy.reports,
+            spi, spi * MAX3421E_MOCK_SPI_NS / 1000, ns);
+
+    max3421e_mock_attach(NULL);
+    run(100);
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t reports = 2000;
+    if (argc > 1) reports = strtoul(argv[1], NULL, 0);
+    if (!reports) return 1;
+
+    // loop of converter runs free, Task() polls MAX3421E in every scan
+    native_scan_period = 100;
+    native_init();
+
+    UsbMockKeyboard boot(false, true);
+    UsbMockKeyboard nkro(true, false);
+    UsbMockHub hub;
+
+    printf("SPI byte: %dns  scan period: %luus\n\n", MAX3421E_MOCK_SPI_NS, (unsigned long)native_scan_period);
+
+    printf("%-20s %8s %10s %10s %8s\n", "enumeration", "ms", "SPI bytes", "transfers", "NAKs");
+    enumeration("boot keyboard", &boot, &boot, NULL);
+    enumeration("NKRO keyboard", &nkro, &nkro, NULL);
+    hub.attach(1, &boot);
+    hub.attach(2, &nkro);
+    enumeration("hub, 2 keyboards", &hub, &boot, &nkro);
+    hub.attach(1, NULL);
+    hub.attach(2, NULL);
+
+    printf("\n%-20s %8s %10s %10s %10s\n", "per report", "reports", "SPI bytes", "target us", "host ns");
+    report_cost("boot keyboard", &boot, reports);
+    report_cost("NKRO keyboard", &nkro, reports);
+    return 0;
+}
@@ -1,40 +1,27 @@
-/*
-Copyright 2012 Jun Wako <wakojun@gmail.com>
-
-This program is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 2 of the License, or
-(at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
 #ifndef CONFIG_H
 #define CONFIG_H
 
 
 #define VENDOR_ID       0xFEED
 #define PRODUCT_ID      0xCAFE
-#define DEVICE_VER      0x0814
+#define DEVICE_VER      0x0001
 #define MANUFACTURER    t.m.k.
 #define PRODUCT         USB to USB keyboard converter
+#define DESCRIPTION     host-native test of USB to USB converter
 
 
-#define DESCRIPTION     Product from t.m.k. keyboard firmware project
-
+/* matrix size of converter/usb_usb */
+#define MATRIX_ROWS 16
+#define MATRIX_COLS 16
 
-/* matrix size */
-#define MATRIX_ROWS 32
-#define MATRIX_COLS 8
+/* hubs and keyboards of converter */
+#define USB_HUB_COUNT   2
+#define USB_KBD_COUNT   4
 
 
 /* key combination for command */
-#define IS_COMMAND() (keyboard_report->mods == (MOD_BIT(KB_LSHIFT) | MOD_BIT(KB_RSHIFT))) 
+#define IS_COMMAND() ( \
+    keyboard_report->mods == (MOD_BIT(KC_LSHIFT) | MOD_BIT(KC_RSHIFT)) \
+)
 
 #endif
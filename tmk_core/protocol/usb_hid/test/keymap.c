@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "keycode.h"
+#include "action.h"
+#include "keymap.h"
+
+
+/* Keymap for test
+ *   matrix position of converter is HID keycode itself, row<<4|col
+ */
+#define ROW(r)  { \
+    (r)|0x0, (r)|0x1, (r)|0x2, (r)|0x3, (r)|0x4, (r)|0x5, (r)|0x6, (r)|0x7, \
+    (r)|0x8, (r)|0x9, (r)|0xA, (r)|0xB, (r)|0xC, (r)|0xD, (r)|0xE, (r)|0xF }
+
+const uint8_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        ROW(0x00), ROW(0x10), ROW(0x20), ROW(0x30), ROW(0x40), ROW(0x50), ROW(0x60), ROW(0x70),
+        ROW(0x80), ROW(0x90), ROW(0xA0), ROW(0xB0), ROW(0xC0), ROW(0xD0), ROW(0xE0), ROW(0xF0),
+    },
+};
+
+const action_t PROGMEM fn_actions[] = {
+    [0] = ACTION_NO,
+};
@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Usb.h"
+#include "max3421e_mock.h"
+#include "usb_device_mock.h"
+#include "timer.h"
+
+
+/*
+ * Chip state
+ */
+static uint8_t usbirq;
+static uint8_t hirq;
+static uint8_t hien;
+static uint8_t mode;
+static uint8_t cpuctl;
+static uint8_t pinctl;
+static uint8_t peraddr;
+static uint8_t hrslt;
+static bool sample;         // SAMPLEBUS done
+static bool busrst;
+static uint32_t busrst_end;
+static uint32_t frame_time;
+static bool rcv_tog;
+static bool snd_tog;
+
+static uint8_t sudfifo[8];
+static uint8_t sud_pos;
+static uint8_t sndfifo[64];
+static uint8_t snd_pos;
+static uint8_t sndbc;
+static uint8_t rcvfifo[64];
+static uint8_t rcv_pos;
+static uint8_t rcvbc;
+
+static UsbMockDevice *root = NULL;
+
+// SPI transaction in progress
+static bool selected = false;
+static uint8_t command;
+static uint8_t count;
+static uint32_t spi_ns;
+
+static max3421e_mock_stat_t stat;
+
+
+static void chip_reset(void)
+{
+    usbirq = hirq = hien = mode = cpuctl = peraddr = hrslt = 0;
+    sample = busrst = false;
+    rcv_tog = snd_tog = false;
+    sud_pos = snd_pos = sndbc = rcv_pos = rcvbc = 0;
+}
+
+/* IRQs which come with time, end of bus reset and SOF frame */
+static void chip_update(void)
+{
+    uint32_t now = timer_read_us();
+    if (busrst && (int32_t)(now - busrst_end) >= 0) {
+        busrst = false;
+        hirq |= bmBUSEVENTIRQ;
+        frame_time = now;
+    }
+    if ((mode & bmSOFKAENAB) && root && !busrst && now - frame_time >= 1000) {
+        hirq |= bmFRAMEIRQ;
+        frame_time = now - (now - frame_time) % 1000;
+    }
+}
+
+/* J/K state of bus in terms of current speed of host */
+static uint8_t bus_state(void)
+{
+    if (!root) return bmSE0;
+    return (root->lowspeed == !!(mode & bmLOWSPEED)) ? bmJSTATUS : bmKSTATUS;
+}
+
+static void transfer(uint8_t token, uint8_t ep)
+{
+    stat.transfers++;
+    UsbMockDevice *dev = (root && !busrst) ? root->find(peraddr) : NULL;
+    uint8_t rc;
+    if (!dev) {
+        // no device answers
+        rc = hrTIMEOUT;
+    } else {
+        switch (token) {
+            case tokSETUP:
+                rc = dev->setup(sudfifo);
+                sud_pos = 0;
+                break;
+            case tokIN:
+                rc = dev->in(ep, rcvfifo, &rcvbc);
+                if (rc == hrSUCCESS) {
+                    rcv_pos = 0;
+                    rcv_tog = !rcv_tog;
+                    hirq |= bmRCVDAVIRQ;
+                }
+                break;
+            case tokOUT:
+                rc = dev->out(ep, sndfifo, sndbc);
+                if (rc == hrSUCCESS) {
+                    snd_pos = 0;
+                    snd_tog = !snd_tog;
+                }
+                break;
+            case tokINHS:
+                rc = dev->status_in();
+                break;
+            case tokOUTHS:
+                rc = dev->status_out();
+                break;
+            default:
+                // isochronous
+                rc = hrBADREQ;
+                break;
+        }
+    }
+    if (rc == hrNAK) stat.naks++;
+    hrslt = rc;
+    hirq |= bmHXFRDNIRQ;
+}
+
+static uint8_t reg_read(uint8_t reg)
+{
+    chip_update();
+    switch (reg) {
+        case rRCVFIFO:
+            return (rcv_pos < sizeof(rcvfifo)) ? rcvfifo[rcv_pos++] : 0;
+        case rRCVBC:
+            return rcvbc;
+        case rSNDBC:
+            return sndbc;
+        case rUSBIRQ:
+            return usbirq;
+        case rCPUCTL:
+            return cpuctl;
+        case rPINCTL:
+            return pinctl;
+        case rREVISION:
+            return 0x13;
+        case rHIRQ:
+            return hirq | bmSNDBAVIRQ;
+        case rHIEN:
+            return hien;
+        case rMODE:
+            return mode;
+        case rPERADDR:
+            return peraddr;
+        case rHCTL:
+            return (busrst ? bmBUSRST : 0) | (sample ? bmSAMPLEBUS : 0);
+        case rHRSL:
+            return bus_state() | (rcv_tog ? bmRCVTOGRD : 0) | (snd_tog ? bmSNDTOGRD : 0) | hrslt;
+        default:
+            return 0;
+    }
+}
+
+static void reg_write(uint8_t reg, uint8_t data)
+{
+    chip_update();
+    switch (reg) {
+        case rSUDFIFO:
+            if (sud_pos < sizeof(sudfifo)) sudfifo[sud_pos++] = data;
+            break;
+        case rSNDFIFO:
+            if (snd_pos < sizeof(sndfifo)) sndfifo[snd_pos++] = data;
+            break;
+        case rSNDBC:
+            sndbc = data;
+            break;
+        case rUSBIRQ:
+            usbirq &= ~data;
+            break;
+        case rUSBCTL:
+            if (data & bmCHIPRES) {
+                chip_reset();
+            } else {
+                // oscillator is stable at once
+                usbirq |= bmOSCOKIRQ;
+            }
+            break;
+        case rCPUCTL:
+            cpuctl = data;
+            break;
+        case rPINCTL:
+            pinctl = data;
+            break;
+        case rHIRQ:
+            hirq &= ~data;
+            if (data & bmRCVDAVIRQ) rcvbc = 0;
+            break;
+        case rHIEN:
+            hien = data;
+            break;
+        case rMODE:
+            if ((data & bmSOFKAENAB) && !(mode & bmSOFKAENAB)) frame_time = timer_read_us();
+            mode = data;
+            break;
+        case rPERADDR:
+            peraddr = data;
+            break;
+        case rHCTL:
+            if (data & bmBUSRST) {
+                busrst = true;
+                busrst_end = timer_read_us() + MAX3421E_MOCK_BUSRST_US;
+                if (root) root->reset();
+            }
+            if (data & bmSAMPLEBUS) sample = true;
+            if (data & bmRCVTOG0) rcv_tog = false;
+            if (data & bmRCVTOG1) rcv_tog = true;
+            if (data & bmSNDTOG0) snd_tog = false;
+            if (data & bmSNDTOG1) snd_tog = true;
+            break;
+        case rHXFR:
+            transfer(data & 0xF0, data & 0x0F);
+            break;
+        default:
+            break;
+    }
+}
+
+
+void max3421e_mock_attach(UsbMockDevice *dev)
+{
+    if (dev == root) return;
+    root = dev;
+    if (root) root->reset();
+    hirq |= bmCONDETIRQ;
+}
+
+UsbMockDevice *max3421e_mock_root(void)
+{
+    return root;
+}
+
+const max3421e_mock_stat_t *max3421e_mock_stat(void)
+{
+    return &stat;
+}
+
+
+/*
+ * Arduino API, see Arduino.h
+ */
+Print Serial;
+SPIClass SPI;
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    stat.spi_bytes++;
+    spi_ns += MAX3421E_MOCK_SPI_NS;
+    if (spi_ns >= 1000) {
+        timer_advance_us(spi_ns / 1000);
+        spi_ns %= 1000;
+    }
+
+    if (!selected) return 0xFF;
+    if (count++ == 0) {
+        // command byte: rrrrr0wa, status is shifted out
+        command = data;
+        return hirq;
+    }
+    if (command & 0x02) {
+        reg_write(command & 0xF8, data);
+        return 0;
+    }
+    return reg_read(command & 0xF8);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin != MAX3421E_MOCK_SS_PIN) return;
+    selected = (val == LOW);
+    count = 0;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin != MAX3421E_MOCK_INT_PIN) return HIGH;
+    // level interrupt, active low
+    chip_update();
+    return ((cpuctl & bmIE) && (hirq & hien)) ? LOW : HIGH;
+}
+
+unsigned long millis(void)
+{
+    return timer_read32();
+}
+
+unsigned long micros(void)
+{
+    return timer_read_us();
+}
+
+/* other work goes on in yield() as override_wiring.c does */
+void delay(unsigned long ms)
+{
+    uint32_t start = timer_read32();
+    while (timer_elapsed32(start) <= ms) {
+        yield();
+        timer_advance_us(100);
+    }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    timer_advance_us(us);
+}
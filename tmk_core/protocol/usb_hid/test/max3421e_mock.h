@@ -0,0 +1,48 @@
+#ifndef MAX3421E_MOCK_H
+#define MAX3421E_MOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * MAX3421E register-level model for host build
+ *
+ * Commands and data bytes from SPI.transfer() are decoded as the chip does:
+ * host control registers, FIFOs, IRQ flags with interrupt pin, bus reset
+ * and SOF frames. A transfer launched with HXFR register is handed to the
+ * device of peripheral address on the bus, see usb_device_mock.h, and done
+ * in no time with result code in HRSL.
+ *
+ * Every SPI byte advances virtual clock by MAX3421E_MOCK_SPI_NS so that time
+ * spent on register access of host Task() is seen in latency.
+ */
+
+/* chip select and interrupt of USB Host Shield, P10 and P9 of UsbCore.h */
+#define MAX3421E_MOCK_SS_PIN    10
+#define MAX3421E_MOCK_INT_PIN   9
+
+/* SPI byte at fclk/2 of 16MHz AVR with loop overhead */
+#ifndef MAX3421E_MOCK_SPI_NS
+#define MAX3421E_MOCK_SPI_NS    1500
+#endif
+
+/* duration of bus reset */
+#define MAX3421E_MOCK_BUSRST_US 50000
+
+class UsbMockDevice;
+
+/* plugs device into root port, NULL unplugs */
+void max3421e_mock_attach(UsbMockDevice *dev);
+UsbMockDevice *max3421e_mock_root(void);
+
+/* traffic counts since start */
+typedef struct {
+    uint32_t spi_bytes;
+    uint32_t transfers;     // HXFR launched
+    uint32_t naks;
+} max3421e_mock_stat_t;
+
+const max3421e_mock_stat_t *max3421e_mock_stat(void);
+
+#endif
@@ -1,92 +1,275 @@
-#include <avr/io.h>
-#include <avr/wdt.h>
-#include <avr/power.h>
-#include <util/delay.h>
-#include <Arduino.h>
-
-// USB HID host
+#include <stdint.h>
+#include <stdbool.h>
 #include "Usb.h"
-#include "hid.h"
-#include "hidboot.h"
-#include "parser.h"
+#include "keycode.h"
+#include "matrix.h"
+#include "led.h"
+#include "timer.h"
+#include "util.h"
+#include "max3421e_mock.h"
+#include "usb_device_mock.h"
+#include "test.h"
 
-// LUFA
-#include "lufa.h"
 
-#include "debug.h"
+/* Regression test of USB to USB converter
+ *
+ * converter/usb_usb runs in keyboard_task() of protocol/native against
+ * scripted keyboards and hub on MAX3421E model. Matrix position of a key is
+ * its HID keycode, see keymap.c.
+ */
+int test_failures = 0;
 
-#include "leonardo_led.h"
+extern USB usb_host;
 
+/* matrix is of USB keyboards, simulated matrix of native.c is not used */
+void native_matrix_set(uint8_t row, uint8_t col, bool pressed) {}
+void native_matrix_clear(void) {}
 
-static USB     usb_host;
-static HIDBoot<HID_PROTOCOL_KEYBOARD>    kbd(&usb_host);
-static KBDReportParser kbd_parser;
+/* LED twinkle of HIDBoot at enumeration */
+#define TWINKLE_REPORTS 6
 
-static void LUFA_setup(void)
-{
-    /* Disable watchdog if enabled by bootloader/fuses */
-    MCUSR &= ~(1 << WDRF);
-    wdt_disable();
+#define CAPS    (1 << USB_LED_CAPS_LOCK)
+#define NUM     (1 << USB_LED_NUM_LOCK)
 
-    /* Disable clock division */
-    clock_prescale_set(clock_div_1);
 
-    // Leonardo needs. Without this USB device is not recognized.
-    USB_Disable();
+static void run(uint32_t ms)
+{
+    uint32_t start = timer_read32();
+    while (timer_elapsed32(start) < ms) {
+        native_task();
+    }
+}
 
-    USB_Init();
+/* keyboard is ready when converter has set LED after twinkle of enumeration */
+static bool ready(UsbMockKeyboard *kbd)
+{
+    return kbd->configuration && kbd->led_reports > TWINKLE_REPORTS;
+}
 
-    // for Console_Task
-    USB_Device_EnableSOFEvents();
+/* runs until keyboard is ready, returns ms taken or 0 on timeout */
+static uint32_t wait_ready(UsbMockKeyboard *kbd, uint32_t timeout)
+{
+    uint32_t start = timer_read32();
+    while (!ready(kbd)) {
+        if (timer_elapsed32(start) > timeout) return 0;
+        native_task();
+    }
+    return timer_elapsed32(start) ?: 1;
+}
+
+static void unplug(void)
+{
+    max3421e_mock_attach(NULL);
+    run(100);
 }
 
-static void HID_setup()
+static bool key_on(uint8_t code)
 {
-    // Arduino Timer startup: wiring.c
-    init();
+    return matrix_is_on(code >> 4, code & 0x0F);
+}
 
-    if (usb_host.Init() == -1) {
-        debug("HID init: failed\n");
-        LED_TX_OFF;
+static uint8_t key_count(void)
+{
+    uint8_t count = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        count += bitpop16(matrix_get_row(row));
     }
-  
-    _delay_ms(200);
-      
-    kbd.SetReportParser(0, (HIDReportParser*)&kbd_parser);
+    return count;
 }
 
-int main(void)
+static const report_keyboard_t *last_report(void)
+{
+    uint16_t n = native_report_count();
+    return n ? test_keyboard_report(n - 1) : NULL;
+}
+
+/* first report since index which has the key */
+static const native_report_t *find_report(uint16_t from, uint8_t key)
 {
-    // LED for debug
-    LED_TX_INIT;
-    LED_TX_ON;
-
-    print_enable = true;
-    debug_enable = true;
-    debug_matrix = true;
-    debug_keyboard = true;
-    debug_mouse = true;
-
-    LUFA_setup();
-    sei();
-
-    // wait for startup of sendchar routine
-    while (USB_DeviceState != DEVICE_STATE_Configured) ;
-    if (debug_enable) {
-        _delay_ms(1000);
+    for (uint16_t i = from; i < native_report_count(); i++) {
+        if (test_report_has(test_keyboard_report(i), key)) return native_report_get(i);
     }
+    return NULL;
+}
+
+
+/* low speed boot keyboard on root port */
+static void test_boot(void)
+{
+    UsbMockKeyboard kbd(false, true);
+    max3421e_mock_attach(&kbd);
+    CHECK(wait_ready(&kbd, 10000));
+    CHECK(usb_host.getUsbTaskState() == USB_STATE_RUNNING);
+    CHECK(usb_host.getVbusState() == LSHOST);
+    CHECK(!kbd.report_protocol);
+    CHECK(kbd.led == 0);
+
+    uint16_t n = native_report_count();
+    kbd.press(KC_A);
+    run(20);
+    CHECK(key_on(KC_A));
+    CHECK(test_report_has(last_report(), KC_A));
+
+    kbd.press(KC_LSHIFT);
+    run(20);
+    CHECK(key_on(KC_LSHIFT));
+    CHECK(last_report() && last_report()->mods == MOD_BIT(KC_LSHIFT));
+
+    kbd.release(KC_A);
+    kbd.release(KC_LSHIFT);
+    run(40);
+    CHECK(key_count() == 0);
+    CHECK(test_report_empty(last_report()));
+    CHECK(native_report_count() - n == 4);
 
-    HID_setup();
-    
-    debug("init: done\n");
-    for (;;) {
-        usb_host.Task();
+    // ErrorRollOver of 7th key leaves keys as they are
+    for (uint8_t code = KC_A; code <= KC_F; code++) kbd.press(code);
+    run(100);
+    CHECK(key_count() == 6);
+    kbd.press(KC_G);
+    run(20);
+    CHECK(key_count() == 6);
+    CHECK(!key_on(KC_G));
+    kbd.release(KC_A);
+    run(20);
+    CHECK(key_count() == 6);
+    CHECK(key_on(KC_G) && !key_on(KC_A));
+    for (uint8_t code = KC_B; code <= KC_G; code++) kbd.release(code);
+    run(100);
+    CHECK(key_count() == 0);
+    CHECK(kbd.dropped == 0);
 
-#if !defined(INTERRUPT_CONTROL_ENDPOINT)
-        // LUFA Task for control request
-        USB_USBTask();
-#endif
+    native_set_leds(CAPS);
+    run(20);
+    CHECK(kbd.led == CAPS);
+    native_set_leds(0);
+    run(20);
+    CHECK(kbd.led == 0);
+
+    unplug();
+    CHECK(usb_host.getUsbTaskState() == USB_DETACHED_SUBSTATE_WAIT_FOR_DEVICE);
+}
+
+/* full speed keyboard with NKRO bitmap in report protocol */
+static void test_nkro(void)
+{
+    static const uint8_t codes[] = {
+        KC_A, KC_S, KC_D, KC_F, KC_J, KC_K, KC_L, KC_SCOLON, KC_SPACE, KC_LSHIFT
+    };
+
+    UsbMockKeyboard kbd(true, false);
+    max3421e_mock_attach(&kbd);
+    CHECK(wait_ready(&kbd, 10000));
+    CHECK(usb_host.getVbusState() == FSHOST);
+    CHECK(kbd.report_protocol);
+
+    for (uint8_t i = 0; i < sizeof(codes); i++) kbd.press(codes[i]);
+    run(150);
+    CHECK(key_count() == sizeof(codes));
+    for (uint8_t i = 0; i < sizeof(codes); i++) CHECK(key_on(codes[i]));
+
+    for (uint8_t i = 0; i < sizeof(codes); i++) kbd.release(codes[i]);
+    run(150);
+    CHECK(key_count() == 0);
+    CHECK(test_report_empty(last_report()));
+
+    // output report with report ID
+    uint16_t reports = kbd.led_reports;
+    native_set_leds(NUM);
+    run(20);
+    CHECK(kbd.led == NUM);
+    CHECK(kbd.led_reports == reports + 1);
+    native_set_leds(0);
+    run(20);
+
+    unplug();
+}
+
+/* keyboards on hub are merged into one matrix */
+static void test_hub(void)
+{
+    UsbMockHub hub;
+    UsbMockKeyboard kbd1(false, true);
+    UsbMockKeyboard kbd2(true, false);
+    UsbMockKeyboard kbd3(false, true);
+    hub.attach(1, &kbd1);
+    hub.attach(2, &kbd2);
+    max3421e_mock_attach(&hub);
+    CHECK(wait_ready(&kbd1, 20000));
+    CHECK(wait_ready(&kbd2, 20000));
+    CHECK(usb_host.getVbusState() == FSHOST);
+    CHECK(kbd2.report_protocol);
+
+    kbd1.press(KC_A);
+    kbd2.press(KC_A);
+    run(30);
+    CHECK(key_on(KC_A));
+    // still held on the other keyboard
+    kbd1.release(KC_A);
+    run(30);
+    CHECK(key_on(KC_A));
+    kbd2.press(KC_B);
+    run(30);
+    CHECK(key_on(KC_B));
+    kbd2.release(KC_A);
+    kbd2.release(KC_B);
+    run(30);
+    CHECK(key_count() == 0);
+
+    native_set_leds(CAPS);
+    run(50);
+    CHECK(kbd1.led == CAPS);
+    CHECK(kbd2.led == CAPS);
+
+    // keyboard plugged later gets LED state, keys of others are served
+    // while it enumerates for seconds
+    uint32_t t = timer_read32();
+    const usb_mock_key_t script[] = {
+        { t + 2000, KC_Z, true },
+        { t + 2050, KC_Z, false },
+    };
+    kbd1.play(script, 2);
+    uint16_t n = native_report_count();
+    hub.attach(3, &kbd3);
+    CHECK(wait_ready(&kbd3, 20000));
+    CHECK(kbd3.led == CAPS);
+    const native_report_t *r = find_report(n, KC_Z);
+    CHECK(r);
+    if (r) {
+        CHECK(r->time / 1000 >= t + 2000);
+        CHECK(r->time / 1000 <= t + 2000 + 20);
+        CHECK(r->time / 1000 < timer_read32() - 20);
     }
-        
-    return 0;
+    CHECK(key_count() == 0);
+
+    // replugged keyboard enumerates again
+    hub.attach(2, NULL);
+    run(300);
+    hub.attach(2, &kbd2);
+    CHECK(wait_ready(&kbd2, 20000));
+    kbd2.press(KC_C);
+    run(30);
+    CHECK(key_on(KC_C));
+    kbd2.release(KC_C);
+    run(30);
+    CHECK(key_count() == 0);
+
+    native_set_leds(0);
+    run(50);
+    unplug();
+}
+
+
+int main(void)
+{
+    // loop of converter runs free, Task() polls MAX3421E in every scan
+    native_scan_period = 100;
+    native_init();
+
+    test_boot();
+    test_nkro();
+    test_hub();
+
+    CHECK(native_report_dropped() == 0);
+    return TEST_RESULT();
 }
@@ -0,0 +1,483 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Usb.h"
+#include "hid.h"
+#include "usbhub.h"
+#include "timer.h"
+#include "usb_device_mock.h"
+
+
+/*
+ * Device
+ */
+UsbMockDevice::UsbMockDevice(bool ls) :
+address(0),
+lowspeed(ls),
+configuration(0),
+requests(0),
+dev_desc(NULL),
+conf_desc(NULL),
+max_packet0(8),
+ctrl_len(0),
+ctrl_pos(0),
+stall(false)
+{
+}
+
+void UsbMockDevice::reset()
+{
+    address = 0;
+    configuration = 0;
+    ctrl_len = ctrl_pos = 0;
+    stall = false;
+}
+
+UsbMockDevice *UsbMockDevice::find(uint8_t addr)
+{
+    return (address == addr) ? this : NULL;
+}
+
+uint8_t UsbMockDevice::setup(const uint8_t *packet)
+{
+    req.bmRequestType = packet[0];
+    req.bRequest = packet[1];
+    req.wValue = packet[2] | (packet[3] << 8);
+    req.wIndex = packet[4] | (packet[5] << 8);
+    req.wLength = packet[6] | (packet[7] << 8);
+    ctrl_len = ctrl_pos = 0;
+    stall = false;
+    requests++;
+
+    if (req.bmRequestType & USB_SETUP_DEVICE_TO_HOST) {
+        stall = !request(&req, ctrl, &ctrl_len);
+        if (ctrl_len > req.wLength) ctrl_len = req.wLength;
+    }
+    // SETUP is always acknowledged
+    return hrSUCCESS;
+}
+
+uint8_t UsbMockDevice::in(uint8_t ep, uint8_t *buf, uint8_t *len)
+{
+    if (ep) return interrupt_in(ep, buf, len);
+    if (stall) return hrSTALL;
+
+    uint16_t n = ctrl_len - ctrl_pos;
+    if (n > max_packet0) n = max_packet0;
+    memcpy(buf, &ctrl[ctrl_pos], n);
+    ctrl_pos += n;
+    *len = n;
+    return hrSUCCESS;
+}
+
+uint8_t UsbMockDevice::out(uint8_t ep, const uint8_t *buf, uint8_t len)
+{
+    if (ep) return interrupt_out(ep, buf, len);
+    if (stall) return hrSTALL;
+
+    // data of OUT request, handled at status stage
+    if (ctrl_len + len > sizeof(ctrl)) len = sizeof(ctrl) - ctrl_len;
+    memcpy(&ctrl[ctrl_len], buf, len);
+    ctrl_len += len;
+    return hrSUCCESS;
+}
+
+uint8_t UsbMockDevice::status_in()
+{
+    if (stall) return hrSTALL;
+    if (!(req.bmRequestType & USB_SETUP_DEVICE_TO_HOST)) {
+        stall = !request(&req, ctrl, &ctrl_len);
+    }
+    return stall ? hrSTALL : hrSUCCESS;
+}
+
+uint8_t UsbMockDevice::status_out()
+{
+    return stall ? hrSTALL : hrSUCCESS;
+}
+
+bool UsbMockDevice::request(const usb_mock_setup_t *r, uint8_t *buf, uint16_t *len)
+{
+    if ((r->bmRequestType & 0x60) != USB_SETUP_TYPE_STANDARD) return false;
+
+    switch (r->bRequest) {
+        case USB_REQUEST_GET_DESCRIPTOR:
+            switch (r->wValue >> 8) {
+                case USB_DESCRIPTOR_DEVICE:
+                    *len = dev_desc[0];
+                    memcpy(buf, dev_desc, *len);
+                    return true;
+                case USB_DESCRIPTOR_CONFIGURATION:
+                    *len = conf_desc[2] | (conf_desc[3] << 8);
+                    memcpy(buf, conf_desc, *len);
+                    return true;
+            }
+            return false;
+        case USB_REQUEST_GET_STATUS:
+            buf[0] = buf[1] = 0;
+            *len = 2;
+            return true;
+        case USB_REQUEST_SET_ADDRESS:
+            // at status stage
+            address = r->wValue & 0x7F;
+            return true;
+        case USB_REQUEST_SET_CONFIGURATION:
+            configuration = r->wValue;
+            return true;
+    }
+    return false;
+}
+
+
+/*
+ * Keyboard
+ */
+#define KBD_EP_INTERVAL     10
+
+/* TMK LUFA boot keyboard */
+static const uint8_t boot_report_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x08, 0x75, 0x01, 0x81, 0x02,
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x75, 0x01, 0x91, 0x0A,
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0xFF, 0x15, 0x00, 0x26, 0xFF, 0x00,
+    0x95, 0x06, 0x75, 0x08, 0x81, 0x00,
+    0xC0
+};
+
+/* report ID 1: modifiers and bitmap of 0x00-0x9F, LED output */
+static const uint8_t nkro_report_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x85, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x08, 0x75, 0x01, 0x81, 0x02,
+    0x19, 0x00, 0x29, USB_MOCK_NKRO_KEYS - 1,
+    0x95, USB_MOCK_NKRO_KEYS, 0x81, 0x02,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x91, 0x02,
+    0x95, 0x03, 0x91, 0x03,
+    0xC0
+};
+
+#define NKRO_REPORT_SIZE    (2 + USB_MOCK_NKRO_KEYS / 8)
+
+/* keyboard with its descriptors, one instance per speed and kind */
+static const uint8_t kbd_dev_desc[2][18] = {
+    // low speed boot keyboard
+    { 0x12, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 8,
+      0xED, 0xFE, 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 1 },
+    // full speed NKRO keyboard
+    { 0x12, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 64,
+      0xED, 0xFE, 0x02, 0x00, 0x00, 0x01, 0, 0, 0, 1 },
+};
+
+#define KBD_CONF_DESC(report_len, ep_size) { \
+    0x09, 0x02, 34, 0x00, 0x01, 0x01, 0x00, 0xA0, 50, \
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00, \
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, (report_len), 0x00, \
+    0x07, 0x05, 0x81, 0x03, (ep_size), 0x00, KBD_EP_INTERVAL }
+
+static const uint8_t kbd_conf_desc[2][34] = {
+    KBD_CONF_DESC(sizeof(boot_report_desc), 8),
+    KBD_CONF_DESC(sizeof(nkro_report_desc), USB_MOCK_REPORT_SIZE),
+};
+
+UsbMockKeyboard::UsbMockKeyboard(bool n, bool ls) :
+UsbMockDevice(ls),
+nkro(n),
+report_protocol(false),
+led(0),
+led_reports(0),
+dropped(0),
+head(0),
+tail(0),
+script(NULL),
+script_len(0)
+{
+    dev_desc = kbd_dev_desc[nkro];
+    conf_desc = kbd_conf_desc[nkro];
+    max_packet0 = dev_desc[7];
+    memset(keys, 0, sizeof(keys));
+}
+
+void UsbMockKeyboard::reset()
+{
+    UsbMockDevice::reset();
+    report_protocol = false;
+    led = 0;
+    led_reports = 0;
+    head = tail = 0;
+}
+
+void UsbMockKeyboard::press(uint8_t code)
+{
+    keys[code >> 3] |= (1 << (code & 7));
+    send();
+}
+
+void UsbMockKeyboard::release(uint8_t code)
+{
+    keys[code >> 3] &= ~(1 << (code & 7));
+    send();
+}
+
+void UsbMockKeyboard::send()
+{
+    uint8_t next = (head + 1) % USB_MOCK_REPORT_QUEUE;
+    if (next == tail) {
+        dropped++;
+        return;
+    }
+    queue_len[head] = report(queue[head]);
+    head = next;
+}
+
+uint8_t UsbMockKeyboard::queued()
+{
+    return (head - tail + USB_MOCK_REPORT_QUEUE) % USB_MOCK_REPORT_QUEUE;
+}
+
+void UsbMockKeyboard::play(const usb_mock_key_t *s, uint8_t len)
+{
+    script = s;
+    script_len = len;
+}
+
+/* report of keys in current protocol, returns its length */
+uint8_t UsbMockKeyboard::report(uint8_t *buf)
+{
+    uint8_t mods = keys[0xE0 >> 3];
+    if (nkro && report_protocol) {
+        buf[0] = 1;
+        buf[1] = mods;
+        memcpy(&buf[2], keys, USB_MOCK_NKRO_KEYS / 8);
+        return NKRO_REPORT_SIZE;
+    }
+
+    memset(buf, 0, 8);
+    buf[0] = mods;
+    uint8_t n = 0;
+    for (uint16_t code = 4; code < 0xE0; code++) {
+        if (!(keys[code >> 3] & (1 << (code & 7)))) continue;
+        if (n == 6) {
+            // ErrorRollOver
+            memset(&buf[2], 0x01, 6);
+            break;
+        }
+        buf[2 + n++] = code;
+    }
+    return 8;
+}
+
+bool UsbMockKeyboard::request(const usb_mock_setup_t *r, uint8_t *buf, uint16_t *len)
+{
+    switch (r->bmRequestType) {
+        case bmREQ_HID_REPORT:
+            if (r->bRequest != USB_REQUEST_GET_DESCRIPTOR || (r->wValue >> 8) != HID_DESCRIPTOR_REPORT) return false;
+            if (nkro) {
+                *len = sizeof(nkro_report_desc);
+                memcpy(buf, nkro_report_desc, *len);
+            } else {
+                *len = sizeof(boot_report_desc);
+                memcpy(buf, boot_report_desc, *len);
+            }
+            return true;
+        case bmREQ_HID_OUT:
+            switch (r->bRequest) {
+                case HID_REQUEST_SET_IDLE:
+                    return true;
+                case HID_REQUEST_SET_PROTOCOL:
+                    report_protocol = r->wValue;
+                    return true;
+                case HID_REQUEST_SET_REPORT:
+                    if (*len == 0) return false;
+                    if (nkro && report_protocol) {
+                        if (*len < 2 || buf[0] != 1) return false;
+                        led = buf[1];
+                    } else {
+                        led = buf[0];
+                    }
+                    led_reports++;
+                    return true;
+            }
+            return false;
+    }
+    return UsbMockDevice::request(r, buf, len);
+}
+
+uint8_t UsbMockKeyboard::interrupt_in(uint8_t ep, uint8_t *buf, uint8_t *len)
+{
+    if (ep != 1 || !configuration) return hrSTALL;
+    while (script_len && (int32_t)(timer_read32() - script->time) >= 0) {
+        if (script->pressed) press(script->code); else release(script->code);
+        script++;
+        script_len--;
+    }
+    if (head == tail) return hrNAK;
+    *len = queue_len[tail];
+    memcpy(buf, queue[tail], *len);
+    tail = (tail + 1) % USB_MOCK_REPORT_QUEUE;
+    return hrSUCCESS;
+}
+
+
+/*
+ * Hub
+ */
+static const uint8_t hub_dev_desc[] = {
+    0x12, 0x01, 0x10, 0x01, 0x09, 0x00, 0x00, 64,
+    0xED, 0xFE, 0x03, 0x00, 0x00, 0x01, 0, 0, 0, 1
+};
+
+static const uint8_t hub_conf_desc[] = {
+    0x09, 0x02, 25, 0x00, 0x01, 0x01, 0x00, 0xE0, 50,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x09, 0x00, 0x00, 0x00,
+    0x07, 0x05, 0x81, 0x03, 0x01, 0x00, 0xFF
+};
+
+static const uint8_t hub_desc[] = {
+    0x09, 0x29, USB_MOCK_HUB_PORTS, 0x00, 0x00, 50, 100, 0x00, 0xFF
+};
+
+UsbMockHub::UsbMockHub() :
+UsbMockDevice(false)
+{
+    dev_desc = hub_dev_desc;
+    conf_desc = hub_conf_desc;
+    max_packet0 = dev_desc[7];
+    for (uint8_t i = 0; i < USB_MOCK_HUB_PORTS; i++) {
+        devs[i] = NULL;
+        status[i] = change[i] = 0;
+    }
+}
+
+void UsbMockHub::reset()
+{
+    UsbMockDevice::reset();
+    // ports are powered off
+    for (uint8_t i = 0; i < USB_MOCK_HUB_PORTS; i++) {
+        status[i] = change[i] = 0;
+        if (devs[i]) devs[i]->reset();
+    }
+}
+
+UsbMockDevice *UsbMockHub::find(uint8_t addr)
+{
+    if (address == addr) return this;
+    for (uint8_t i = 0; i < USB_MOCK_HUB_PORTS; i++) {
+        if (!devs[i] || !(status[i] & bmHUB_PORT_STATUS_PORT_ENABLE)) continue;
+        UsbMockDevice *dev = devs[i]->find(addr);
+        if (dev) return dev;
+    }
+    return NULL;
+}
+
+void UsbMockHub::attach(uint8_t port, UsbMockDevice *dev)
+{
+    uint8_t i = port - 1;
+    if (i >= USB_MOCK_HUB_PORTS || dev == devs[i]) return;
+    devs[i] = dev;
+    if (!(status[i] & bmHUB_PORT_STATUS_PORT_POWER)) return;
+
+    status[i] &= ~(bmHUB_PORT_STATUS_PORT_CONNECTION | bmHUB_PORT_STATUS_PORT_ENABLE | bmHUB_PORT_STATUS_PORT_LOW_SPEED);
+    if (dev) {
+        dev->reset();
+        status[i] |= bmHUB_PORT_STATUS_PORT_CONNECTION | (dev->lowspeed ? bmHUB_PORT_STATUS_PORT_LOW_SPEED : 0);
+    }
+    change[i] |= bmHUB_PORT_STATUS_C_PORT_CONNECTION;
+}
+
+bool UsbMockHub::request(const usb_mock_setup_t *r, uint8_t *buf, uint16_t *len)
+{
+    uint8_t i = r->wIndex - 1;
+    bool port = (i < USB_MOCK_HUB_PORTS);
+
+    switch (r->bmRequestType) {
+        case bmREQ_GET_HUB_DESCRIPTOR:
+            if (r->bRequest == USB_REQUEST_GET_DESCRIPTOR) {
+                *len = sizeof(hub_desc);
+                memcpy(buf, hub_desc, *len);
+                return true;
+            }
+            if (r->bRequest == USB_REQUEST_GET_STATUS) {
+                memset(buf, 0, 4);
+                *len = 4;
+                return true;
+            }
+            return false;
+        case bmREQ_SET_HUB_FEATURE:
+            return (r->bRequest == USB_REQUEST_SET_FEATURE || r->bRequest == USB_REQUEST_CLEAR_FEATURE);
+        case bmREQ_GET_PORT_STATUS:
+            if (r->bRequest != USB_REQUEST_GET_STATUS || !port) return false;
+            buf[0] = status[i];
+            buf[1] = status[i] >> 8;
+            buf[2] = change[i];
+            buf[3] = change[i] >> 8;
+            *len = 4;
+            return true;
+        case bmREQ_SET_PORT_FEATURE:
+            if (!port) return false;
+            if (r->bRequest == USB_REQUEST_SET_FEATURE) {
+                switch (r->wValue) {
+                    case HUB_FEATURE_PORT_POWER:
+                        if (status[i] & bmHUB_PORT_STATUS_PORT_POWER) return true;
+                        status[i] |= bmHUB_PORT_STATUS_PORT_POWER;
+                        if (devs[i]) {
+                            UsbMockDevice *dev = devs[i];
+                            devs[i] = NULL;
+                            attach(r->wIndex, dev);
+                        }
+                        return true;
+                    case HUB_FEATURE_PORT_RESET:
+                        // reset completes at once
+                        if (!(status[i] & bmHUB_PORT_STATUS_PORT_CONNECTION)) return true;
+                        devs[i]->reset();
+                        status[i] |= bmHUB_PORT_STATUS_PORT_ENABLE;
+                        change[i] |= bmHUB_PORT_STATUS_C_PORT_RESET;
+                        return true;
+                    case HUB_FEATURE_PORT_SUSPEND:
+                        return true;
+                }
+                return false;
+            }
+            if (r->bRequest == USB_REQUEST_CLEAR_FEATURE) {
+                switch (r->wValue) {
+                    case HUB_FEATURE_PORT_ENABLE:
+                        status[i] &= ~bmHUB_PORT_STATUS_PORT_ENABLE;
+                        return true;
+                    case HUB_FEATURE_PORT_POWER:
+                        status[i] = 0;
+                        change[i] = 0;
+                        return true;
+                    case HUB_FEATURE_C_PORT_CONNECTION:
+                        change[i] &= ~bmHUB_PORT_STATUS_C_PORT_CONNECTION;
+                        return true;
+                    case HUB_FEATURE_C_PORT_ENABLE:
+                        change[i] &= ~bmHUB_PORT_STATUS_C_PORT_ENABLE;
+                        return true;
+                    case HUB_FEATURE_C_PORT_RESET:
+                        change[i] &= ~bmHUB_PORT_STATUS_C_PORT_RESET;
+                        return true;
+                    case HUB_FEATURE_C_PORT_SUSPEND:
+                    case HUB_FEATURE_C_PORT_OVER_CURRENT:
+                        return true;
+                }
+            }
+            return false;
+    }
+    return UsbMockDevice::request(r, buf, len);
+}
+
+uint8_t UsbMockHub::interrupt_in(uint8_t ep, uint8_t *buf, uint8_t *len)
+{
+    if (ep != 1 || !configuration) return hrSTALL;
+    uint8_t bits = 0;
+    for (uint8_t i = 0; i < USB_MOCK_HUB_PORTS; i++) {
+        if (change[i]) bits |= (1 << (i + 1));
+    }
+    if (!bits) return hrNAK;
+    buf[0] = bits;
+    *len = 1;
+    return hrSUCCESS;
+}
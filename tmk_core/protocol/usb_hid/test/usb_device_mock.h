@@ -0,0 +1,157 @@
+#ifndef USB_DEVICE_MOCK_H
+#define USB_DEVICE_MOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Usb.h"
+
+
+/*
+ * Scripted USB devices on bus of MAX3421E model
+ *
+ * Packets are answered with MAX3421E result codes, hrSUCCESS, hrNAK or
+ * hrSTALL. Control transfers of endpoint 0 are handled by the base class;
+ * IN request is answered at SETUP stage and OUT request takes effect at
+ * status stage, so address is changed after SET_ADDRESS completes.
+ */
+#define USB_MOCK_CTRL_SIZE      256
+#define USB_MOCK_REPORT_SIZE    32
+#define USB_MOCK_REPORT_QUEUE   32
+
+typedef struct {
+    uint8_t  bmRequestType;
+    uint8_t  bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} usb_mock_setup_t;
+
+class UsbMockDevice
+{
+public:
+    uint8_t address;
+    bool lowspeed;
+    uint8_t configuration;
+    // requests received, for checks
+    uint16_t requests;
+
+    UsbMockDevice(bool ls);
+    virtual ~UsbMockDevice() {}
+
+    /* bus reset or port reset: default address, not configured */
+    virtual void reset();
+    /* device of address reachable through this one, hub ports for example */
+    virtual UsbMockDevice *find(uint8_t addr);
+
+    uint8_t setup(const uint8_t *packet);
+    uint8_t in(uint8_t ep, uint8_t *buf, uint8_t *len);
+    uint8_t out(uint8_t ep, const uint8_t *buf, uint8_t len);
+    /* status stage, handshake IN after OUT request and OUT after IN request */
+    uint8_t status_in();
+    uint8_t status_out();
+
+protected:
+    const uint8_t *dev_desc;
+    const uint8_t *conf_desc;
+    uint8_t max_packet0;
+
+    /* handles request, IN data is put in buf with its length, false stalls */
+    virtual bool request(const usb_mock_setup_t *req, uint8_t *buf, uint16_t *len);
+    virtual uint8_t interrupt_in(uint8_t ep, uint8_t *buf, uint8_t *len) { return hrSTALL; }
+    virtual uint8_t interrupt_out(uint8_t ep, const uint8_t *buf, uint8_t len) { return hrSTALL; }
+
+private:
+    usb_mock_setup_t req;
+    uint8_t ctrl[USB_MOCK_CTRL_SIZE];
+    uint16_t ctrl_len;
+    uint16_t ctrl_pos;
+    bool stall;
+};
+
+
+/*
+ * Keyboard
+ *
+ * Boot keyboard reports 8 bytes of 6KRO. NKRO keyboard has report descriptor
+ * with report ID 1 of modifiers and bitmap of usages 0x00-0x9F, it reports
+ * the bitmap after SET_PROTOCOL(report) and 6KRO in boot protocol. A report
+ * is queued for each change of keys and sent on IN of its endpoint, NAK
+ * while none is queued.
+ */
+#define USB_MOCK_NKRO_KEYS  0xA0
+
+/* scripted key change at virtual time(ms) */
+typedef struct {
+    uint32_t time;
+    uint8_t  code;
+    bool     pressed;
+} usb_mock_key_t;
+
+class UsbMockKeyboard : public UsbMockDevice
+{
+public:
+    bool nkro;
+    bool report_protocol;
+    uint8_t led;
+    // SET_REPORT of LED since reset
+    uint16_t led_reports;
+    // reports lost when queue is full
+    uint16_t dropped;
+
+    UsbMockKeyboard(bool nkro, bool ls);
+    void reset();
+
+    void press(uint8_t code);
+    void release(uint8_t code);
+    /* queues report of keys down */
+    void send();
+    uint8_t queued();
+    /* key changes applied when endpoint is polled at or after their time */
+    void play(const usb_mock_key_t *script, uint8_t len);
+
+protected:
+    bool request(const usb_mock_setup_t *req, uint8_t *buf, uint16_t *len);
+    uint8_t interrupt_in(uint8_t ep, uint8_t *buf, uint8_t *len);
+
+private:
+    uint8_t keys[32];
+    uint8_t queue[USB_MOCK_REPORT_QUEUE][USB_MOCK_REPORT_SIZE];
+    uint8_t queue_len[USB_MOCK_REPORT_QUEUE];
+    uint8_t head;
+    uint8_t tail;
+    const usb_mock_key_t *script;
+    uint8_t script_len;
+    uint8_t report(uint8_t *buf);
+};
+
+
+/*
+ * Hub
+ *
+ * Ports are powered with SET_FEATURE and reset completes at once. Change of
+ * port status is reported with bitmap on IN of endpoint 1. Devices of ports
+ * are powered off on reset of hub.
+ */
+#define USB_MOCK_HUB_PORTS  4
+
+class UsbMockHub : public UsbMockDevice
+{
+public:
+    UsbMockHub();
+    void reset();
+    UsbMockDevice *find(uint8_t addr);
+
+    /* plugs device into port 1-4, NULL unplugs */
+    void attach(uint8_t port, UsbMockDevice *dev);
+
+protected:
+    bool request(const usb_mock_setup_t *req, uint8_t *buf, uint16_t *len);
+    uint8_t interrupt_in(uint8_t ep, uint8_t *buf, uint8_t *len);
+
+private:
+    UsbMockDevice *devs[USB_MOCK_HUB_PORTS];
+    uint16_t status[USB_MOCK_HUB_PORTS];
+    uint16_t change[USB_MOCK_HUB_PORTS];
+};
+
+#endif
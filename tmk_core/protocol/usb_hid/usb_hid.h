@@ -7,4 +7,14 @@
 extern report_keyboard_t usb_hid_keyboard_report;
 extern uint16_t usb_hid_time_stamp;
 
+/*
+ * Called repeatedly while delay() waits, as Arduino does. USB Host Shield
+ * library waits with delay() during enumeration, for seconds in total, then
+ * other devices ready can be served in it. Default is empty.
+ */
+#ifdef __cplusplus
+extern "C"
+#endif
+void yield(void);
+
 #endif
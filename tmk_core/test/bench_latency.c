@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "keycode.h"
+#include "action.h"
+#include "action_tapping.h"
+#include "timer.h"
+#include "native.h"
+#include "keyboard_profile.h"
+#include "keymap_native.h"
+#include "test.h"
+
+
+/* Keystroke latency benchmark
+ *
+ * Measures virtual time and number of scans from the matrix_scan() edge
+ * which settles an action to the first send_keyboard() carrying its result.
+ * Timing of each run is varied with fixed seed so that numbers are stable
+ * between builds.
+ *
+ *   usage: bench_latency [runs] [scan period(us)]
+ */
+int test_failures = 0;
+
+#define TRACE_MAX   8
+
+typedef struct {
+    native_event_t trace[TRACE_MAX];
+    uint8_t len;
+    uint8_t trigger;    /* index of edge which latency is measured from */
+    uint8_t key;        /* expected key in report */
+    uint8_t mods;       /* expected mods in report */
+} scenario_t;
+
+typedef void (*scenario_func_t)(scenario_t *s, uint32_t t);
+
+
+static uint32_t seed = 1;
+static uint32_t rnd(uint32_t min, uint32_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    return min + (seed>>16) % (max - min + 1);
+}
+
+#define MAX(a, b)   ((a) > (b) ? (a) : (b))
+#define EV(t, p, ...)   (native_event_t){ .time = (t), .row = TEST_ROW(__VA_ARGS__), .col = TEST_COL(__VA_ARGS__), .pressed = (p) }
+
+
+static void plain_key(scenario_t *s, uint32_t t)
+{
+    s->trace[0] = EV(t, true, POS_A);
+    s->trace[1] = EV(t + rnd(20, 120), false, POS_A);
+    s->len = 2; s->trigger = 0; s->key = KC_A; s->mods = 0;
+}
+
+static void layer_tap_key_tap(scenario_t *s, uint32_t t)
+{
+    uint32_t r = t + rnd(20, TAPPING_TERM - 20);
+    s->trace[0] = EV(t, true, POS_LT1_SPC);
+    s->trace[1] = EV(r, false, POS_LT1_SPC);
+    s->len = 2; s->trigger = 1; s->key = KC_SPC; s->mods = 0;
+}
+
+static void layer_tap_key_hold(scenario_t *s, uint32_t t)
+{
+    uint32_t a = t + rnd(20, 300);
+    uint32_t ar = a + rnd(20, 120);
+    s->trace[0] = EV(t, true, POS_LT1_SPC);
+    s->trace[1] = EV(a, true, POS_A);
+    s->trace[2] = EV(ar, false, POS_A);
+    // release after TAPPING_TERM so that the key is held
+    s->trace[3] = EV(MAX(ar, t + TAPPING_TERM) + rnd(10, 50), false, POS_LT1_SPC);
+    s->len = 4; s->trigger = 1; s->key = KC_1; s->mods = 0;
+}
+
+static void mods_tap_key_tap(scenario_t *s, uint32_t t)
+{
+    uint32_t r = t + rnd(20, TAPPING_TERM - 20);
+    s->trace[0] = EV(t, true, POS_LCTL_ESC);
+    s->trace[1] = EV(r, false, POS_LCTL_ESC);
+    s->len = 2; s->trigger = 1; s->key = KC_ESC; s->mods = 0;
+}
+
+static void mods_tap_key_hold(scenario_t *s, uint32_t t)
+{
+    uint32_t a = t + rnd(20, 300);
+    uint32_t ar = a + rnd(20, 120);
+    s->trace[0] = EV(t, true, POS_LCTL_ESC);
+    s->trace[1] = EV(a, true, POS_A);
+    s->trace[2] = EV(ar, false, POS_A);
+    // release after TAPPING_TERM so that the key is held
+    s->trace[3] = EV(MAX(ar, t + TAPPING_TERM) + rnd(10, 50), false, POS_LCTL_ESC);
+    s->len = 4; s->trigger = 1; s->key = KC_A; s->mods = MOD_BIT(KC_LCTL);
+}
+
+static void oneshot_mods(scenario_t *s, uint32_t t)
+{
+    uint32_t r = t + rnd(20, TAPPING_TERM - 20);
+    uint32_t a = r + rnd(20, 300);
+    s->trace[0] = EV(t, true, POS_OSM_SFT);
+    s->trace[1] = EV(r, false, POS_OSM_SFT);
+    s->trace[2] = EV(a, true, POS_A);
+    s->trace[3] = EV(a + rnd(20, 120), false, POS_A);
+    s->len = 4; s->trigger = 2; s->key = KC_A; s->mods = MOD_BIT(KC_LSFT);
+}
+
+static void macro(scenario_t *s, uint32_t t)
+{
+    s->trace[0] = EV(t, true, POS_MACRO);
+    s->trace[1] = EV(t + rnd(20, 120), false, POS_MACRO);
+    s->len = 2; s->trigger = 0; s->key = KC_H; s->mods = 0;
+}
+
+static const struct {
+    const char *name;
+    scenario_func_t func;
+} scenarios[] = {
+    { "plain key",              plain_key },
+    { "LAYER_TAP_KEY tap",      layer_tap_key_tap },
+    { "LAYER_TAP_KEY hold",     layer_tap_key_hold },
+    { "MODS_TAP_KEY tap",       mods_tap_key_tap },
+    { "MODS_TAP_KEY hold",      mods_tap_key_hold },
+    { "oneshot mods",           oneshot_mods },
+    { "macro",                  macro },
+};
+
+
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(uint32_t *v, uint32_t n, uint8_t p)
+{
+    return v[(uint32_t)((n - 1) * p / 100)];
+}
+
+/* returns false if expected report is not found */
+static bool measure(scenario_func_t func, uint32_t *time, uint32_t *scans)
+{
+    scenario_t s;
+    func(&s, timer_read32() + 10);
+
+    // run until the trigger edge, then from it
+    native_report_clear();
+    native_run(s.trace, s.trigger, s.trace[s.trigger].time);
+    uint16_t from = native_report_count();
+    uint32_t edge_time = timer_read_us();
+    uint32_t edge_scan = native_scan_count();
+    native_run(&s.trace[s.trigger], s.len - s.trigger, s.trace[s.len - 1].time + 1000);
+
+    for (uint16_t i = from; i < native_report_count(); i++) {
+        const report_keyboard_t *r = test_keyboard_report(i);
+        if (test_report_has(r, s.key) && (r->mods & s.mods) == s.mods) {
+            *time = native_report_get(i)->time - edge_time;
+            *scans = native_report_get(i)->scan - edge_scan;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+    if (argc > 2) native_scan_period = strtoul(argv[2], NULL, 0);
+    if (runs == 0 || native_scan_period == 0) {
+        fprintf(stderr, "usage: %s [runs] [scan period(us)]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t *time = malloc(sizeof(uint32_t) * runs);
+    uint32_t *scans = malloc(sizeof(uint32_t) * runs);
+    if (!time || !scans) return 1;
+
+    native_init();
+
+    printf("runs: %lu  scan period: %luus  TAPPING_TERM: %ums\n",
+            (unsigned long)runs, (unsigned long)native_scan_period, TAPPING_TERM);
+    printf("%-20s %10s %10s %10s %8s %8s %8s\n",
+            "action", "p50(us)", "p99(us)", "max(us)", "p50(sc)", "p99(sc)", "max(sc)");
+    for (uint8_t k = 0; k < sizeof(scenarios)/sizeof(scenarios[0]); k++) {
+        seed = 1;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < runs; i++) {
+            if (measure(scenarios[k].func, &time[n], &scans[n])) {
+                n++;
+            }
+        }
+        if (n != runs) {
+            printf("%s: expected report missing in %lu runs\n",
+                    scenarios[k].name, (unsigned long)(runs - n));
+            test_failures++;
+        }
+        if (n == 0) continue;
+
+        qsort(time, n, sizeof(uint32_t), compare);
+        qsort(scans, n, sizeof(uint32_t), compare);
+        printf("%-20s %10lu %10lu %10lu %8lu %8lu %8lu\n", scenarios[k].name,
+                (unsigned long)percentile(time, n, 50),
+                (unsigned long)percentile(time, n, 99),
+                (unsigned long)time[n - 1],
+                (unsigned long)percentile(scans, n, 50),
+                (unsigned long)percentile(scans, n, 99),
+                (unsigned long)scans[n - 1]);
+    }
+
+    // host CPU time(ns) spent in each stage of keyboard_task()
+    profile_print();
+
+    free(time);
+    free(scans);
+    return test_failures ? 1 : 0;
+}
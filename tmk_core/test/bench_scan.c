@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "keyboard.h"
+#include "matrix.h"
+#include "timer.h"
+#include "native.h"
+
+
+/*
+ * Host CPU time of keyboard_task() from matrix scan to key event
+ *
+ * Keys of row BENCH_ROW are toggled every scan and virtual clock advances
+ * by scan period. Build with MATRIX_COLS=16 or 32 to see wide matrix, which
+ * 'make bench' does as well.
+ */
+#define BENCH_ROW   2
+/* best of repeats is taken to shed noise of host */
+#define BENCH_REPEAT    5
+
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* returns ns per keyboard_task() toggling columns of 'cols' */
+static double run(matrix_row_t cols, uint32_t scans)
+{
+    bool on = false;
+    native_matrix_clear();
+    native_report_clear();
+    keyboard_task();
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < scans; i++) {
+        if (cols) {
+            on = !on;
+            for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+                if (cols & ((matrix_row_t)1<<c)) native_matrix_set(BENCH_ROW, c, on);
+            }
+        }
+        keyboard_task();
+        timer_advance_us(native_scan_period);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    native_matrix_clear();
+    keyboard_task();
+    return (double)elapsed / scans;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t scans = 200000;
+    if (argc > 1) scans = strtoul(argv[1], NULL, 0);
+    if (!scans) return 1;
+
+    native_init();
+
+    const struct {
+        const char *name;
+        matrix_row_t cols;
+    } patterns[] = {
+        { "idle",               0 },
+        { "1 key, first col",   (matrix_row_t)1 },
+        { "1 key, last col",    (matrix_row_t)1<<(MATRIX_COLS - 1) },
+        { "2 keys, both ends",  (matrix_row_t)1 | (matrix_row_t)1<<(MATRIX_COLS - 1) },
+    };
+
+    printf("scans: %lu  matrix: %dx%d\n", (unsigned long)scans, MATRIX_ROWS, MATRIX_COLS);
+    printf("%-20s %10s\n", "pattern", "ns/scan");
+    for (uint8_t k = 0; k < sizeof(patterns)/sizeof(patterns[0]); k++) {
+        double best = run(patterns[k].cols, scans);
+        for (uint8_t i = 1; i < BENCH_REPEAT; i++) {
+            double ns = run(patterns[k].cols, scans);
+            if (ns < best) best = ns;
+        }
+        printf("%-20s %10.1f\n", patterns[k].name, best);
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+
+#define VENDOR_ID       0xFEED
+#define PRODUCT_ID      0x0000
+#define DEVICE_VER      0x0001
+#define MANUFACTURER    t.m.k.
+#define PRODUCT         Native
+#define DESCRIPTION     host-native simulation of tmk_core
+
+
+/* key matrix size */
+#ifndef MATRIX_ROWS
+#define MATRIX_ROWS 8
+#endif
+#ifndef MATRIX_COLS
+#define MATRIX_COLS 8
+#endif
+
+
+/* key combination for command */
+#define IS_COMMAND() ( \
+    keyboard_report->mods == (MOD_BIT(KC_LSHIFT) | MOD_BIT(KC_RSHIFT)) \
+)
+
+#endif
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "keycode.h"
+#include "action.h"
+#include "action_layer.h"
+#include "action_util.h"
+#include "native.h"
+
+
+/*
+ * Deterministic fuzzer of tapping, layer and oneshot processing
+ *
+ *   fuzz_action [runs [seed]]
+ *
+ * Each input is decoded to a key event trace with random intervals and run
+ * through matrix scan and action_exec() on virtual time. Keys still down are
+ * released at the end and after tapping settles these must hold:
+ *   - no key and no mods(real and weak) left
+ *   - layer_state and default_layer_state as at start
+ *   - last keyboard report has no key and no mods but pending oneshot, last
+ *     mouse report has no button, last system and consumer report is 0
+ *
+ * A failing trace is minimized and saved as fuzz_<seed>_<run>.trace, which
+ * 'replay' tool reproduces. On crash the trace is saved as is.
+ *
+ * For libFuzzer build with -DFUZZ_LIBFUZZER -fsanitize=fuzzer, then
+ * LLVMFuzzerTestOneInput() is the entry instead of main().
+ */
+#define FUZZ_EVENTS     200
+/* settling time after last event, longer than TAPPING_TERM */
+#define FUZZ_SETTLE     1000
+
+static native_event_t trace[FUZZ_EVENTS + MATRIX_ROWS * MATRIX_COLS];
+static uint16_t trace_len;
+static char trace_file[64] = "fuzz_crash.trace";
+
+/* rows picked for event, weighted to tap keys on row 1 */
+static const uint8_t fuzz_rows[8] = { 0, 0, 1, 1, 1, 1, 2, 6 };
+
+
+/* two bytes per event: key and interval, first byte gives start time */
+static uint16_t decode(const uint8_t *data, size_t size)
+{
+    bool down[MATRIX_ROWS][MATRIX_COLS] = {};
+    uint32_t time = 10;
+    uint16_t n = 0;
+
+    // start just before wrap of 16-bit timer at times
+    if (size && (data[0] & 1)) {
+        time = 0x10000 - 2 * data[0];
+    }
+    for (size_t i = 1; i + 1 < size && n < FUZZ_EVENTS; i += 2) {
+        uint8_t row = fuzz_rows[(data[i] >> 3) & 7];
+        uint8_t col = data[i] & 7;
+        // mostly fast typing, sometimes over tapping term
+        uint8_t b = data[i + 1];
+        time += (b < 192 ? b & 63 : (b - 192) * 8);
+
+        down[row][col] = !down[row][col];
+        trace[n++] = (native_event_t){ .time = time, .row = row, .col = col, .pressed = down[row][col] };
+    }
+    // release all
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            if (down[r][c]) {
+                time += 10;
+                trace[n++] = (native_event_t){ .time = time, .row = r, .col = c, .pressed = false };
+            }
+        }
+    }
+    return n;
+}
+
+static const native_report_t *last_report(uint8_t kind)
+{
+    for (uint16_t i = native_report_count(); i > 0; i--) {
+        const native_report_t *r = native_report_get(i - 1);
+        if (r->kind == kind) return r;
+    }
+    return NULL;
+}
+
+/* runs trace from clean state, returns violated invariant or NULL */
+static const char *run(const native_event_t *t, uint16_t len)
+{
+    // trace may leave keys down once minimized, invariants don't apply
+    bool down[MATRIX_ROWS][MATRIX_COLS] = {};
+    for (uint16_t i = 0; i < len; i++) {
+        down[t[i].row][t[i].col] = t[i].pressed;
+    }
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            if (down[r][c]) return NULL;
+        }
+    }
+
+    native_init();
+    clear_keyboard();
+    clear_oneshot_mods();
+    layer_clear();
+    native_report_clear();
+
+    uint32_t default_layer = default_layer_state;
+    native_run(t, len, (len ? t[len - 1].time : 0) + FUZZ_SETTLE);
+#ifdef COMMAND_ENABLE
+    // Magic command switches default layer as it should
+    default_layer = default_layer_state;
+#endif
+
+    if (has_anykey()) return "key is left";
+    if (get_mods()) return "mods are left";
+    if (get_weak_mods()) return "weak mods are left";
+    if (layer_state) return "layer_state is not restored";
+    if (default_layer_state != default_layer) return "default_layer_state is changed";
+
+    // log is not complete
+    if (native_report_dropped()) return NULL;
+
+    const native_report_t *r;
+    // pending oneshot mods are sent with any report until next key
+    if ((r = last_report(NATIVE_REPORT_KEYBOARD))) {
+        if (r->keyboard.mods & ~get_oneshot_mods()) return "keyboard report has mods";
+        for (uint8_t i = 1; i < KEYBOARD_REPORT_SIZE; i++) {
+            if (r->keyboard.raw[i]) return "keyboard report has key";
+        }
+    }
+    // motion is relative, only buttons can be stuck
+    if ((r = last_report(NATIVE_REPORT_MOUSE)) && r->mouse.buttons) return "mouse button is left";
+    if ((r = last_report(NATIVE_REPORT_SYSTEM)) && r->usage) return "system usage is left";
+    if ((r = last_report(NATIVE_REPORT_CONSUMER)) && r->usage) return "consumer usage is left";
+    return NULL;
+}
+
+/* removes chunks of events as long as it still fails */
+static uint16_t minimize(native_event_t *t, uint16_t len)
+{
+    static native_event_t tmp[sizeof(trace) / sizeof(trace[0])];
+    for (uint16_t chunk = len / 2; chunk > 0; chunk /= 2) {
+        for (uint16_t i = 0; i < len; ) {
+            uint16_t n = (i + chunk < len) ? chunk : len - i;
+            memcpy(tmp, t, i * sizeof(t[0]));
+            memcpy(tmp + i, t + i + n, (len - i - n) * sizeof(t[0]));
+            if (run(tmp, len - n)) {
+                memcpy(t, tmp, (len - n) * sizeof(t[0]));
+                len -= n;
+            } else {
+                i += n;
+            }
+        }
+    }
+    return len;
+}
+
+static void save(const char *path, const native_event_t *t, uint16_t len, const char *reason)
+{
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return;
+    }
+    fprintf(out, "# %s\n", reason);
+    for (uint16_t i = 0; i < len; i++) {
+        fprintf(out, "%lu %u %u %c\n", (unsigned long)t[i].time, t[i].row, t[i].col, t[i].pressed ? 'd' : 'u');
+    }
+    fclose(out);
+}
+
+static void crash(int sig)
+{
+    save(trace_file, trace, trace_len, "crash");
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* returns 0, otherwise stops process on failure like libFuzzer does */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    trace_len = decode(data, size);
+    const char *reason = run(trace, trace_len);
+    if (reason) {
+        printf("%s: %s, %u events\n", trace_file, reason, trace_len);
+        trace_len = minimize(trace, trace_len);
+        printf("minimized to %u events\n", trace_len);
+        save(trace_file, trace, trace_len, reason);
+        fflush(stdout);
+        signal(SIGABRT, SIG_DFL);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+    // xorshift32
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t runs = 300;
+    uint32_t seed = 1;
+    static uint8_t data[2 * FUZZ_EVENTS + 1];
+
+    if (argc > 1) runs = strtoul(argv[1], NULL, 0);
+    if (argc > 2) seed = strtoul(argv[2], NULL, 0);
+
+    signal(SIGSEGV, crash);
+    signal(SIGABRT, crash);
+    for (uint32_t i = 0; i < runs; i++) {
+        rnd_state = seed * 2654435761UL + i + 1;
+        size_t size = 1 + rnd() % sizeof(data);
+        for (size_t j = 0; j < size; j++) {
+            data[j] = rnd();
+        }
+        snprintf(trace_file, sizeof(trace_file), "fuzz_%lu_%lu.trace", (unsigned long)seed, (unsigned long)i);
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    printf("OK: %lu runs\n", (unsigned long)runs);
+    return 0;
+}
+#endif
@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "keycode.h"
+#include "action.h"
+#include "action_macro.h"
+#include "report.h"
+#include "keymap.h"
+#include "keymap_native.h"
+
+
+/* Keymap for simulation
+ *   row 0: A B C D E F G H
+ *   row 1: LSft LCtl Fn0(LT1/Spc) Fn1(LCtl/Esc) Fn2(OneshotSft) Fn3(Macro) Fn4(MO1) RSft
+ *   other rows: I-Z, 1-0 and so on
+ */
+const uint8_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        { KC_A,    KC_B,    KC_C,    KC_D,    KC_E,    KC_F,    KC_G,    KC_H    },
+        { KC_LSFT, KC_LCTL, KC_FN0,  KC_FN1,  KC_FN2,  KC_FN3,  KC_FN4,  KC_RSFT },
+        { KC_I,    KC_J,    KC_K,    KC_L,    KC_M,    KC_N,    KC_O,    KC_P    },
+        { KC_Q,    KC_R,    KC_S,    KC_T,    KC_U,    KC_V,    KC_W,    KC_X    },
+        { KC_Y,    KC_Z,    KC_1,    KC_2,    KC_3,    KC_4,    KC_5,    KC_6    },
+        { KC_7,    KC_8,    KC_9,    KC_0,    KC_ENT,  KC_ESC,  KC_BSPC, KC_TAB  },
+        { KC_MUTE, KC_VOLU, KC_VOLD, KC_PWR,  KC_MS_U, KC_MS_D, KC_BTN1, KC_WH_U },
+        { KC_F1,   KC_F2,   KC_F3,   KC_F4,   KC_F5,   KC_F6,   KC_F7,   KC_F8   },
+    },
+    [1] = {
+        { KC_1,    KC_2,    KC_3,    KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+        { KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS },
+    },
+};
+
+const action_t PROGMEM fn_actions[] = {
+    [0] = ACTION_LAYER_TAP_KEY(1, KC_SPC),
+    [1] = ACTION_MODS_TAP_KEY(MOD_LCTL, KC_ESC),
+    [2] = ACTION_MODS_ONESHOT(MOD_LSFT),
+    [3] = ACTION_MACRO(0),
+    [4] = ACTION_LAYER_MOMENTARY(1),
+};
+
+const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt)
+{
+    (void)opt;
+    switch (id) {
+        case 0:
+            return (record->event.pressed ?
+                    MACRO( T(H), T(I), END ) :
+                    MACRO_NONE );
+    }
+    return MACRO_NONE;
+}
@@ -0,0 +1,17 @@
+#ifndef KEYMAP_NATIVE_H
+#define KEYMAP_NATIVE_H
+
+/* matrix position of keys in keymap.c */
+#define POS_A       0, 0
+#define POS_B       0, 1
+#define POS_C       0, 2
+#define POS_LSFT    1, 0
+#define POS_LCTL    1, 1
+#define POS_LT1_SPC 1, 2
+#define POS_LCTL_ESC 1, 3
+#define POS_OSM_SFT 1, 4
+#define POS_MACRO   1, 5
+#define POS_MO1     1, 6
+#define POS_RSFT    1, 7
+
+#endif
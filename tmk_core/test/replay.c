@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "native.h"
+
+
+/* Replays trace file and prints reports with virtual time(us) and scan count
+ *
+ *   usage: replay [-r|-e] <trace file>|-
+ *
+ * With -r input is console log with dump of keyboard_record.h, its row changes
+ * are replayed. With -e its action_exec() inputs are replayed instead.
+ */
+#define TRACE_MAX   4096
+static native_event_t trace[TRACE_MAX];
+
+int main(int argc, char *argv[])
+{
+    const char *mode = NULL;
+    if (argc > 2 && (strcmp(argv[1], "-r") == 0 || strcmp(argv[1], "-e") == 0)) {
+        mode = argv[1];
+        argc--;
+        argv++;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s [-r|-e] <trace file>|-\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = stdin;
+    if (strcmp(argv[1], "-") != 0) {
+        in = fopen(argv[1], "r");
+        if (!in) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    int n;
+    if (mode) {
+        n = native_record_load(in, trace, TRACE_MAX, mode[1] == 'e');
+    } else {
+        n = native_trace_load(in, trace, TRACE_MAX);
+    }
+    if (n < 0) {
+        fprintf(stderr, mode ? "record: no dump or not of this matrix\n" : "trace: syntax error\n");
+        return 1;
+    }
+
+    native_init();
+    // run until 1s after last event to settle tapping and oneshot
+    native_run(trace, n, (n ? trace[n-1].time : 0) + 1000);
+
+    for (uint16_t i = 0; i < native_report_count(); i++) {
+        native_report_print(stdout, native_report_get(i));
+    }
+    if (native_report_dropped()) {
+        fprintf(stderr, "report log overflow: %u dropped\n", native_report_dropped());
+    }
+    return 0;
+}
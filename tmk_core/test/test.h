@@ -0,0 +1,64 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "host.h"
+#include "native.h"
+
+
+/* minimal check utility for native programs */
+extern int test_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define TEST_RESULT()   (test_failures ? (printf("FAILED: %d\n", test_failures), 1) : (printf("OK\n"), 0))
+
+/* key event of trace, position is given as 'row, col' */
+#define PRESS(t, ...)   { .time = (t), .row = TEST_ROW(__VA_ARGS__), .col = TEST_COL(__VA_ARGS__), .pressed = true }
+#define RELEASE(t, ...) { .time = (t), .row = TEST_ROW(__VA_ARGS__), .col = TEST_COL(__VA_ARGS__), .pressed = false }
+#define TEST_ROW(r, c)  (r)
+#define TEST_COL(r, c)  (c)
+
+#define TRACE_LEN(t)    (sizeof(t)/sizeof((t)[0]))
+
+/* keyboard report of log, NULL if not keyboard report */
+static inline const report_keyboard_t *test_keyboard_report(uint16_t i)
+{
+    const native_report_t *r = native_report_get(i);
+    return (r && r->kind == NATIVE_REPORT_KEYBOARD) ? &r->keyboard : NULL;
+}
+
+/* whether keyboard report has the key */
+static inline bool test_report_has(const report_keyboard_t *report, uint8_t key)
+{
+    if (!report) return false;
+#ifdef NKRO_ENABLE
+    // report is rendered in protocol of the time
+    if (keyboard_protocol && keyboard_nkro) {
+        return (key >> 3) < KEYBOARD_REPORT_BITS && (report->nkro.bits[key >> 3] & (1 << (key & 7)));
+    }
+#endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] == key) return true;
+    }
+    return false;
+}
+
+/* whether keyboard report has no key and no modifier */
+static inline bool test_report_empty(const report_keyboard_t *report)
+{
+    if (!report) return false;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_SIZE; i++) {
+        if (report->raw[i]) return false;
+    }
+    return true;
+}
+
+#endif
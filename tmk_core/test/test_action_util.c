@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include "keycode.h"
+#include "host.h"
+#include "action_util.h"
+#include "native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+static const report_keyboard_t *last_report(void)
+{
+    return test_keyboard_report(native_report_count() - 1);
+}
+
+static void reset(void)
+{
+#ifdef NKRO_ENABLE
+    // slots of boot report are checked, bitmap in test_nkro()
+    keyboard_protocol = 0;
+#endif
+    clear_keys();
+    clear_mods();
+    send_keyboard_report();
+    native_report_clear();
+}
+
+static void test_add_del(void)
+{
+    reset();
+    add_key(KC_A);
+    add_key(KC_A);
+    CHECK(has_anykey() == 1);
+    add_key(KC_B);
+    CHECK(has_anykey() == 2);
+    del_key(KC_C);
+    CHECK(has_anykey() == 2);
+    send_keyboard_report();
+    CHECK(test_report_has(last_report(), KC_A));
+    CHECK(test_report_has(last_report(), KC_B));
+    CHECK(get_first_key() == KC_A);
+
+    del_key(KC_A);
+    del_key(KC_A);
+    CHECK(has_anykey() == 1);
+    send_keyboard_report();
+    CHECK(!test_report_has(last_report(), KC_A));
+    CHECK(test_report_has(last_report(), KC_B));
+
+    clear_keys();
+    CHECK(has_anykey() == 0);
+    send_keyboard_report();
+    CHECK(test_report_empty(last_report()));
+}
+
+static int8_t slot_of(const report_keyboard_t *report, uint8_t key)
+{
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report->keys[i] == key) return i;
+    }
+    return -1;
+}
+
+static void test_stable_slot(void)
+{
+    reset();
+    add_key(KC_A);
+    add_key(KC_B);
+    add_key(KC_C);
+    send_keyboard_report();
+    int8_t b = slot_of(last_report(), KC_B);
+    int8_t c = slot_of(last_report(), KC_C);
+    CHECK(b >= 0 && c >= 0);
+
+    // remaining keys stay in their slot
+    del_key(KC_A);
+    send_keyboard_report();
+    CHECK(slot_of(last_report(), KC_A) == -1);
+    CHECK(slot_of(last_report(), KC_B) == b);
+    CHECK(slot_of(last_report(), KC_C) == c);
+}
+
+static void test_over_6keys(void)
+{
+    const uint8_t keys[] = { KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H };
+    reset();
+    for (uint8_t i = 0; i < sizeof(keys); i++) {
+        add_key(keys[i]);
+    }
+    CHECK(has_anykey() == sizeof(keys));
+    send_keyboard_report();
+#ifdef USB_6KRO_ENABLE
+    // newest keys roll oldest out
+    CHECK(!test_report_has(last_report(), KC_A));
+    CHECK(!test_report_has(last_report(), KC_B));
+    CHECK(test_report_has(last_report(), KC_H));
+#else
+    CHECK(!test_report_has(last_report(), KC_G));
+    CHECK(!test_report_has(last_report(), KC_H));
+#endif
+
+    // keys left out of report are reported when slots are free
+    del_key(KC_A);
+    del_key(KC_B);
+    send_keyboard_report();
+    CHECK(test_report_has(last_report(), KC_G));
+    CHECK(test_report_has(last_report(), KC_H));
+
+    for (uint8_t i = 0; i < sizeof(keys); i++) {
+        del_key(keys[i]);
+    }
+    CHECK(has_anykey() == 0);
+    send_keyboard_report();
+    CHECK(test_report_empty(last_report()));
+}
+
+#ifdef NKRO_ENABLE
+static void test_nkro(void)
+{
+    const uint8_t keys[] = { KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H };
+    reset();
+    keyboard_protocol = 1;
+    keyboard_nkro = true;
+    for (uint8_t i = 0; i < sizeof(keys); i++) {
+        add_key(keys[i]);
+    }
+    send_keyboard_report();
+    for (uint8_t i = 0; i < sizeof(keys); i++) {
+        CHECK(test_report_has(last_report(), keys[i]));
+    }
+
+    // host switches to boot protocol while keys are held
+    keyboard_protocol = 0;
+    send_keyboard_report();
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < sizeof(keys); i++) {
+        if (slot_of(last_report(), keys[i]) >= 0) n++;
+    }
+    CHECK(n == 6);
+    // no bitmap left beyond boot report
+    for (uint8_t i = 2 + 6; i < KEYBOARD_REPORT_SIZE; i++) {
+        CHECK(last_report()->raw[i] == 0);
+    }
+
+    // and back to report protocol, no keycode of boot report left in bitmap
+    del_key(KC_A);
+    keyboard_protocol = 1;
+    send_keyboard_report();
+    CHECK(!test_report_has(last_report(), KC_A));
+    for (uint8_t i = 1; i < sizeof(keys); i++) {
+        CHECK(test_report_has(last_report(), keys[i]));
+    }
+    CHECK(last_report()->nkro.bits[KC_A >> 3] == (0xF0 & ~(1 << (KC_A & 7))));
+    CHECK(last_report()->nkro.bits[KC_E >> 3] == 0x0F);
+    for (uint8_t i = 2; i < KEYBOARD_REPORT_BITS; i++) {
+        CHECK(last_report()->nkro.bits[i] == 0);
+    }
+
+    clear_keys();
+    send_keyboard_report();
+    CHECK(test_report_empty(last_report()));
+    keyboard_protocol = 0;
+}
+#endif
+
+int main(void)
+{
+    native_init();
+
+    test_add_del();
+    test_stable_slot();
+    test_over_6keys();
+#ifdef NKRO_ENABLE
+    test_nkro();
+#endif
+
+    return TEST_RESULT();
+}
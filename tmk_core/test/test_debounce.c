@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+#include "matrix.h"
+#include "timer.h"
+#include "debounce.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+static matrix_row_t raw[MATRIX_ROWS];
+static matrix_row_t cooked[MATRIX_ROWS];
+
+
+static void reset(void)
+{
+    memset(raw, 0, sizeof(raw));
+    memset(cooked, 0, sizeof(cooked));
+    timer_clear();
+    debounce_init();
+}
+
+/* scan once after 'us' */
+static bool scan(uint32_t us)
+{
+    timer_advance_us(us);
+    return debounce(raw, cooked);
+}
+
+static void test_eager_press(void)
+{
+    reset();
+    raw[0] = 0x01;
+    CHECK(scan(1000) == true);
+    CHECK(cooked[0] == 0x01);
+
+    // chatter after press is ignored
+    raw[0] = 0x00;
+    CHECK(scan(1000) == false);
+    raw[0] = 0x01;
+    CHECK(scan(1000) == false);
+    CHECK(cooked[0] == 0x01);
+}
+
+static void test_deferred_release(void)
+{
+    reset();
+    raw[0] = 0x01;
+    scan(1000);
+
+    raw[0] = 0x00;
+    for (uint8_t i = 1; i < DEBOUNCE; i++) {
+        CHECK(scan(1000) == false);
+        CHECK(cooked[0] == 0x01);
+    }
+    CHECK(scan(1000) == true);
+    CHECK(cooked[0] == 0x00);
+}
+
+static void test_release_bounce(void)
+{
+    reset();
+    raw[0] = 0x01;
+    scan(1000);
+
+    // bounce restarts count of the key
+    raw[0] = 0x00;
+    scan(1000);
+    scan(1000);
+    raw[0] = 0x01;
+    scan(1000);
+    raw[0] = 0x00;
+    for (uint8_t i = 1; i < DEBOUNCE; i++) {
+        scan(1000);
+        CHECK(cooked[0] == 0x01);
+    }
+    scan(1000);
+    CHECK(cooked[0] == 0x00);
+}
+
+static void test_per_key(void)
+{
+    reset();
+    raw[0] = 0x01;
+    raw[3] = 0x80;
+    scan(1000);
+
+    // other keys are not delayed by releasing key
+    raw[0] = 0x02;
+    scan(1000);
+    CHECK(cooked[0] == 0x03);
+    raw[1] = 0x10;
+    scan(1000);
+    CHECK(cooked[1] == 0x10);
+    for (uint8_t i = 2; i < DEBOUNCE; i++) {
+        scan(1000);
+    }
+    CHECK(cooked[0] == 0x02);
+    CHECK(cooked[1] == 0x10);
+    CHECK(cooked[3] == 0x80);
+}
+
+static void test_fast_scan(void)
+{
+    reset();
+    raw[0] = 0x01;
+    scan(1000);
+
+    // counters advance once a millisecond however fast matrix is scanned
+    raw[0] = 0x00;
+    for (uint16_t i = 0; i < (DEBOUNCE - 1) * 10; i++) {
+        scan(100);
+    }
+    CHECK(cooked[0] == 0x01);
+    for (uint16_t i = 0; i < 10; i++) {
+        scan(100);
+    }
+    CHECK(cooked[0] == 0x00);
+}
+
+int main(void)
+{
+    test_eager_press();
+    test_deferred_release();
+    test_release_bounce();
+    test_per_key();
+    test_fast_scan();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "keyboard.h"
+#include "matrix.h"
+#include "keyevent_queue.h"
+#include "native.h"
+#include "test.h"
+
+#ifndef MATRIX_HAS_GHOST
+#   error "test_ghost: build with MATRIX_HAS_GHOST"
+#endif
+
+
+int test_failures = 0;
+
+
+/*
+ * Reference of keyboard_scan() with ghost check which scans other rows
+ */
+static matrix_row_t ref_matrix[MATRIX_ROWS];
+static matrix_row_t ref_prev[MATRIX_ROWS];
+
+static bool ref_has_ghost_in_row(uint8_t row)
+{
+    matrix_row_t matrix_row = ref_matrix[row];
+    if (((matrix_row - 1) & matrix_row) == 0)
+        return false;
+    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+        if (i != row && (ref_matrix[i] & matrix_row))
+            return true;
+    }
+    return false;
+}
+
+/* key events of a scan in order, up to queue size */
+static uint8_t ref_scan(keyevent_t *events)
+{
+    uint8_t n = 0;
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row_t change = ref_matrix[r] ^ ref_prev[r];
+        if (!change || ref_has_ghost_in_row(r)) continue;
+        for (uint8_t c = 0; c < MATRIX_COLS && n < KEYEVENT_QUEUE_SIZE; c++) {
+            if (!(change & ((matrix_row_t)1<<c))) continue;
+            events[n++] = (keyevent_t){
+                .key = (keypos_t){ .row = r, .col = c },
+                .pressed = (ref_matrix[r] & ((matrix_row_t)1<<c))
+            };
+            ref_prev[r] ^= ((matrix_row_t)1<<c);
+        }
+    }
+    return n;
+}
+
+static void set_key(uint8_t row, uint8_t col, bool pressed)
+{
+    native_matrix_set(row, col, pressed);
+    if (pressed) {
+        ref_matrix[row] |= ((matrix_row_t)1<<col);
+    } else {
+        ref_matrix[row] &= ~((matrix_row_t)1<<col);
+    }
+}
+
+/* scans and compares queued events with reference */
+static void scan_check(void)
+{
+    keyevent_t expected[KEYEVENT_QUEUE_SIZE];
+    uint8_t n = ref_scan(expected);
+
+    keyboard_scan();
+    keyevent_t e;
+    uint8_t i = 0;
+    while (keyevent_queue_get(&e)) {
+        CHECK(i < n);
+        if (i < n) {
+            CHECK(e.key.row == expected[i].key.row);
+            CHECK(e.key.col == expected[i].key.col);
+            CHECK(e.pressed == expected[i].pressed);
+        }
+        i++;
+    }
+    CHECK(i == n);
+}
+
+/* classic ghost: three corners of rectangle are down */
+static void test_rectangle(void)
+{
+    set_key(0, 0, true);
+    set_key(0, 1, true);
+    scan_check();
+    // row 1 shares column 1 with row 0 and has two keys
+    set_key(1, 1, true);
+    set_key(1, 2, true);
+    scan_check();
+    CHECK(ref_prev[1] == 0);
+    // blocked until ghost is gone
+    set_key(0, 1, false);
+    scan_check();
+    CHECK(ref_prev[1] == ((1<<1) | (1<<2)));
+
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) set_key(r, c, false);
+    }
+    scan_check();
+    scan_check();
+}
+
+/* random walk of matrix, several keys changed per scan */
+static void test_random(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < 200000; i++) {
+        uint8_t toggles = 1 + rand() % 3;
+        while (toggles--) {
+            // a few rows and columns to make ghost often
+            uint8_t row = rand() % 4;
+            uint8_t col = rand() % MATRIX_COLS;
+            // released more often than pressed to keep some rows clean
+            if (ref_matrix[row] & ((matrix_row_t)1<<col)) {
+                set_key(row, col, false);
+            } else if (rand() % 3 == 0) {
+                set_key(row, col, true);
+            }
+        }
+        scan_check();
+        if (test_failures) {
+            printf("at scan %lu\n", (unsigned long)i);
+            return;
+        }
+    }
+}
+
+int main(void)
+{
+    native_init();
+
+    test_rectangle();
+    test_random();
+
+    return TEST_RESULT();
+}
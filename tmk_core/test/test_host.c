@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+static const report_mouse_t *mouse_report(uint16_t i)
+{
+    const native_report_t *r = native_report_get(i);
+    return (r && r->kind == NATIVE_REPORT_MOUSE) ? &r->mouse : NULL;
+}
+
+static void test_keyboard_dedup(void)
+{
+    report_keyboard_t report;
+    memset(&report, 0, sizeof(report));
+    native_report_clear();
+
+    report.keys[0] = 0x04;
+    host_keyboard_send(&report);
+    host_keyboard_send(&report);
+    CHECK(native_report_count() == 1);
+
+    report.mods = 0x02;
+    host_keyboard_send(&report);
+    host_keyboard_send(&report);
+    CHECK(native_report_count() == 2);
+
+    // new driver gets full state again
+    host_set_driver(&native_driver);
+    host_keyboard_send(&report);
+    CHECK(native_report_count() == 3);
+
+    memset(&report, 0, sizeof(report));
+    host_keyboard_send(&report);
+    CHECK(native_report_count() == 4);
+}
+
+static void test_system_dedup(void)
+{
+    native_report_clear();
+    host_system_send(0x81);
+    host_system_send(0x81);
+    host_system_send(0);
+    host_consumer_send(0xE9);
+    host_consumer_send(0xE9);
+    host_consumer_send(0);
+    CHECK(native_report_count() == 4);
+}
+
+#ifdef HOST_MOUSE_MERGE
+static void test_mouse_merge(void)
+{
+    report_mouse_t m = { .buttons = 0, .x = 10, .y = -5 };
+    native_report_clear();
+
+    // motion of same buttons is summed and sent once
+    host_mouse_send(&m);
+    host_mouse_send(&m);
+    m.v = 1;
+    host_mouse_send(&m);
+    CHECK(native_report_count() == 0);
+    host_mouse_flush();
+    CHECK(native_report_count() == 1);
+    CHECK(mouse_report(0) && mouse_report(0)->x == 30 && mouse_report(0)->y == -15 && mouse_report(0)->v == 1);
+
+    // button change is not merged
+    native_report_clear();
+    m = (report_mouse_t){ .buttons = 1 };
+    host_mouse_send(&m);
+    m.x = 3;
+    host_mouse_send(&m);
+    m = (report_mouse_t){ .buttons = 0 };
+    host_mouse_send(&m);
+    host_mouse_flush();
+    CHECK(native_report_count() == 2);
+    CHECK(mouse_report(0) && mouse_report(0)->buttons == 1 && mouse_report(0)->x == 3);
+    CHECK(mouse_report(1) && mouse_report(1)->buttons == 0);
+
+    // motion over range of report is split, not clipped
+    native_report_clear();
+    m = (report_mouse_t){ .x = 100 };
+    host_mouse_send(&m);
+    host_mouse_send(&m);
+    host_mouse_flush();
+    CHECK(native_report_count() == 2);
+    CHECK(mouse_report(0) && mouse_report(0)->x == 100);
+    CHECK(mouse_report(1) && mouse_report(1)->x == 100);
+
+    // no motion and no button change
+    native_report_clear();
+    m = (report_mouse_t){ 0 };
+    host_mouse_send(&m);
+    host_mouse_flush();
+    CHECK(native_report_count() == 0);
+}
+#else
+static void test_mouse_send(void)
+{
+    report_mouse_t m = { .buttons = 0, .x = 10, .y = -5 };
+    native_report_clear();
+
+    // each report is sent as it is, flush has nothing to send
+    host_mouse_send(&m);
+    host_mouse_send(&m);
+    CHECK(native_report_count() == 2);
+    host_mouse_flush();
+    CHECK(native_report_count() == 2);
+    CHECK(mouse_report(1) && mouse_report(1)->x == 10 && mouse_report(1)->y == -5);
+
+    // no motion and no button change
+    m = (report_mouse_t){ 0 };
+    host_mouse_send(&m);
+    CHECK(native_report_count() == 2);
+    m.buttons = 1;
+    host_mouse_send(&m);
+    CHECK(native_report_count() == 3);
+    m.buttons = 0;
+    host_mouse_send(&m);
+    CHECK(native_report_count() == 4);
+}
+#endif
+
+int main(void)
+{
+    native_init();
+
+    test_keyboard_dedup();
+    test_system_dedup();
+#ifdef HOST_MOUSE_MERGE
+    test_mouse_merge();
+#else
+    test_mouse_send();
+#endif
+
+    return TEST_RESULT();
+}
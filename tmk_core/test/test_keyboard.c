@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include "keycode.h"
+#include "native.h"
+#include "keymap_native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+static void test_plain_key(void)
+{
+    const native_event_t trace[] = {
+        PRESS(10, POS_A),
+        RELEASE(50, POS_A),
+    };
+    native_report_clear();
+    native_run(trace, TRACE_LEN(trace), 100);
+
+    CHECK(native_report_count() == 2);
+    CHECK(test_report_has(test_keyboard_report(0), KC_A));
+    CHECK(test_report_empty(test_keyboard_report(1)));
+    // reported on the scan which sees the edge
+    CHECK(native_report_get(0)->time == 10 * 1000UL);
+    CHECK(native_report_get(1)->time == 50 * 1000UL);
+}
+
+static void test_layer_tap_key(void)
+{
+    // tap: space is sent on release
+    const native_event_t tap[] = {
+        PRESS(1000, POS_LT1_SPC),
+        RELEASE(1050, POS_LT1_SPC),
+    };
+    native_report_clear();
+    native_run(tap, TRACE_LEN(tap), 1500);
+
+    CHECK(native_report_count() == 2);
+    CHECK(test_report_has(test_keyboard_report(0), KC_SPC));
+    CHECK(native_report_get(0)->time == 1050 * 1000UL);
+    CHECK(test_report_empty(test_keyboard_report(1)));
+
+    // hold: layer 1 is on and A position gives 1
+    const native_event_t hold[] = {
+        PRESS(2000, POS_LT1_SPC),
+        PRESS(2300, POS_A),
+        RELEASE(2350, POS_A),
+        RELEASE(2400, POS_LT1_SPC),
+    };
+    native_report_clear();
+    native_run(hold, TRACE_LEN(hold), 3000);
+
+    CHECK(native_report_count() == 2);
+    CHECK(test_report_has(test_keyboard_report(0), KC_1));
+    CHECK(test_report_empty(test_keyboard_report(1)));
+}
+
+static void test_mods_tap_key(void)
+{
+    // hold with other key: LCtl + A
+    const native_event_t hold[] = {
+        PRESS(4000, POS_LCTL_ESC),
+        PRESS(4300, POS_A),
+        RELEASE(4350, POS_A),
+        RELEASE(4400, POS_LCTL_ESC),
+    };
+    native_report_clear();
+    native_run(hold, TRACE_LEN(hold), 5000);
+
+    const report_keyboard_t *r;
+    CHECK(native_report_count() == 4);
+    CHECK((r = test_keyboard_report(0)) && r->mods == MOD_BIT(KC_LCTL));
+    CHECK((r = test_keyboard_report(1)) && r->mods == MOD_BIT(KC_LCTL) && test_report_has(r, KC_A));
+    CHECK(test_report_empty(test_keyboard_report(3)));
+}
+
+static void test_oneshot_mods(void)
+{
+    const native_event_t trace[] = {
+        PRESS(6000, POS_OSM_SFT),
+        RELEASE(6050, POS_OSM_SFT),
+        PRESS(6100, POS_A),
+        RELEASE(6150, POS_A),
+    };
+    native_report_clear();
+    native_run(trace, TRACE_LEN(trace), 7000);
+
+    const report_keyboard_t *r = NULL;
+    for (uint16_t i = 0; i < native_report_count(); i++) {
+        if (test_report_has(test_keyboard_report(i), KC_A)) {
+            r = test_keyboard_report(i);
+            break;
+        }
+    }
+    CHECK(r && r->mods == MOD_BIT(KC_LSFT));
+    CHECK(test_report_empty(test_keyboard_report(native_report_count() - 1)));
+}
+
+static void test_macro(void)
+{
+    const native_event_t trace[] = {
+        PRESS(8000, POS_MACRO),
+        RELEASE(8050, POS_MACRO),
+    };
+    native_report_clear();
+    native_run(trace, TRACE_LEN(trace), 9000);
+
+    // T(H), T(I)
+    CHECK(native_report_count() == 4);
+    CHECK(test_report_has(test_keyboard_report(0), KC_H));
+    CHECK(test_report_empty(test_keyboard_report(1)));
+    CHECK(test_report_has(test_keyboard_report(2), KC_I));
+    CHECK(test_report_empty(test_keyboard_report(3)));
+}
+
+static void test_layer_change(void)
+{
+    // same key gives action of layer state at press, see LAYER_CACHE_ENABLE
+    const native_event_t trace[] = {
+        PRESS(10000, POS_A),
+        RELEASE(10050, POS_A),
+        PRESS(10100, POS_MO1),
+        PRESS(10150, POS_A),
+        RELEASE(10200, POS_MO1),
+        RELEASE(10250, POS_A),
+        PRESS(10300, POS_A),
+        RELEASE(10350, POS_A),
+    };
+    native_report_clear();
+    native_run(trace, TRACE_LEN(trace), 11000);
+
+    CHECK(native_report_count() == 6);
+    CHECK(test_report_has(test_keyboard_report(0), KC_A));
+    CHECK(test_report_empty(test_keyboard_report(1)));
+    CHECK(test_report_has(test_keyboard_report(2), KC_1));
+    // released as pressed on layer 1
+    CHECK(test_report_empty(test_keyboard_report(3)));
+    CHECK(native_report_get(3)->time == 10250 * 1000UL);
+    CHECK(test_report_has(test_keyboard_report(4), KC_A));
+    CHECK(test_report_empty(test_keyboard_report(5)));
+}
+
+int main(void)
+{
+    native_init();
+
+    test_plain_key();
+    test_layer_tap_key();
+    test_mods_tap_key();
+    test_oneshot_mods();
+    test_macro();
+    test_layer_change();
+
+    return TEST_RESULT();
+}
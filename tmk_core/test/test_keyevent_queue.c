@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include "keycode.h"
+#include "keyboard.h"
+#include "matrix.h"
+#include "keyevent_queue.h"
+#include "hook.h"
+#include "native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+/* key events processed, keyboard report doesn't tell all of them over 6KRO.
+ * counted as state changes since the hook may see an event more than once. */
+static uint16_t event_count = 0;
+static matrix_row_t event_state[MATRIX_ROWS];
+
+void hook_matrix_change(keyevent_t event)
+{
+    matrix_row_t bit = (matrix_row_t)1<<event.key.col;
+    if (event.pressed != !!(event_state[event.key.row] & bit)) {
+        event_state[event.key.row] ^= bit;
+        event_count++;
+    }
+}
+
+static keyevent_t event(uint8_t row, uint8_t col, uint16_t time)
+{
+    return (keyevent_t){ .key = (keypos_t){ .row = row, .col = col }, .pressed = true, .time = time };
+}
+
+static void test_fifo(void)
+{
+    keyevent_t e;
+    keyevent_queue_clear();
+    CHECK(keyevent_queue_empty());
+    CHECK(!keyevent_queue_get(&e));
+
+    // wrap around index many times
+    for (uint16_t i = 1; i < 1000; i++) {
+        CHECK(keyevent_queue_put(event(i % MATRIX_ROWS, 1, i)));
+        CHECK(keyevent_queue_put(event(i % MATRIX_ROWS, 2, i)));
+        CHECK(keyevent_queue_get(&e) && e.time == i && e.key.col == 1);
+        CHECK(keyevent_queue_get(&e) && e.time == i && e.key.col == 2);
+    }
+    CHECK(keyevent_queue_empty());
+    CHECK(keyevent_queue_overflow() == 0);
+}
+
+static void test_overflow(void)
+{
+    keyevent_t e;
+    keyevent_queue_clear();
+    for (uint8_t i = 0; i < KEYEVENT_QUEUE_SIZE; i++) {
+        CHECK(keyevent_queue_put(event(0, i, i + 1)));
+    }
+    CHECK(!keyevent_queue_put(event(1, 0, 100)));
+    CHECK(!keyevent_queue_put(event(1, 1, 100)));
+    CHECK(keyevent_queue_overflow() == 2);
+
+    // nothing queued is overwritten
+    for (uint8_t i = 0; i < KEYEVENT_QUEUE_SIZE; i++) {
+        CHECK(keyevent_queue_get(&e) && e.time == i + 1);
+    }
+    CHECK(!keyevent_queue_get(&e));
+    keyevent_queue_clear();
+    CHECK(keyevent_queue_overflow() == 0);
+}
+
+static void test_no_key_lost(void)
+{
+    // more keys than queue in one scan are carried over to next scan
+    uint8_t n = 0;
+    native_matrix_clear();
+    native_report_clear();
+    keyevent_queue_clear();
+    for (uint8_t r = 2; r < MATRIX_ROWS && n <= KEYEVENT_QUEUE_SIZE; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS && n <= KEYEVENT_QUEUE_SIZE; c++, n++) {
+            native_matrix_set(r, c, true);
+        }
+    }
+    event_count = 0;
+    native_task();
+    CHECK(keyevent_queue_overflow() > 0);
+    CHECK(event_count == KEYEVENT_QUEUE_SIZE);
+    native_task();
+    CHECK(event_count == n);
+
+    native_matrix_clear();
+    native_task();
+    native_task();
+    CHECK(event_count == 2 * n);
+    CHECK(test_report_empty(test_keyboard_report(native_report_count() - 1)));
+}
+
+int main(void)
+{
+    native_init();
+
+    test_fifo();
+    test_overflow();
+    test_no_key_lost();
+
+    return TEST_RESULT();
+}
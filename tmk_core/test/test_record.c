@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "keyboard_record.h"
+#include "native.h"
+#include "keymap_native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+static native_event_t loaded[256];
+
+/* dumps record to console and loads it back */
+static int dump_load(bool events)
+{
+    FILE *tmp = tmpfile();
+    fflush(stdout);
+    int out = dup(STDOUT_FILENO);
+    dup2(fileno(tmp), STDOUT_FILENO);
+    record_dump();
+    fflush(stdout);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+
+    rewind(tmp);
+    int n = native_record_load(tmp, loaded, TRACE_LEN(loaded), events);
+    fclose(tmp);
+    return n;
+}
+
+static bool same_event(const native_event_t *a, const native_event_t *b, uint32_t slack)
+{
+    return a->row == b->row && a->col == b->col && a->pressed == b->pressed &&
+           a->time + slack >= b->time && b->time + slack >= a->time;
+}
+
+/* typing while layer tap key is held, events wait in queue until it settles */
+static const native_event_t typing[] = {
+    PRESS(100, POS_A),
+    PRESS(120, POS_B),
+    RELEASE(150, POS_A),
+    RELEASE(170, POS_B),
+    PRESS(300, POS_LT1_SPC),
+    PRESS(320, POS_C),
+    RELEASE(340, POS_C),
+    PRESS(345, 2, 0),
+    PRESS(345, 2, 1),
+    RELEASE(360, 2, 0),
+    RELEASE(360, 2, 1),
+    RELEASE(500, POS_LT1_SPC),
+};
+
+static void test_rows(void)
+{
+    native_init();
+    native_run(typing, TRACE_LEN(typing), 1000);
+
+    int n = dump_load(false);
+    CHECK(n == TRACE_LEN(typing));
+    for (int i = 0; i < n && i < (int)TRACE_LEN(typing); i++) {
+        CHECK(same_event(&loaded[i], &typing[i], 0));
+    }
+}
+
+static void test_events(void)
+{
+    native_init();
+    native_run(typing, TRACE_LEN(typing), 1000);
+
+    // event time is odd, scan order is row first
+    int n = dump_load(true);
+    CHECK(n == TRACE_LEN(typing));
+    for (int i = 0; i < n && i < (int)TRACE_LEN(typing); i++) {
+        CHECK(same_event(&loaded[i], &typing[i], 1));
+    }
+}
+
+/* oldest entries are dropped and the rest are kept intact */
+static void test_overflow(void)
+{
+    static native_event_t trace[400];
+    uint16_t len = 0;
+    for (uint16_t i = 0; i < TRACE_LEN(trace) / 2; i++) {
+        uint8_t col = i % 3;
+        // long interval needs more bytes of delta
+        uint32_t t = 10 + i * (i % 5 ? 20 : 300);
+        if (len) t += trace[len - 1].time;
+        trace[len++] = (native_event_t)PRESS(t, 0, col);
+        trace[len++] = (native_event_t)RELEASE(t + 5, 0, col);
+    }
+
+    native_init();
+    native_run(trace, len, trace[len - 1].time + 100);
+
+    int n = dump_load(false);
+    CHECK(n > 0 && n < len);
+    // times are since base, which is the entry before first
+    uint32_t base = 0;
+    for (int i = 0; i < n; i++) {
+        const native_event_t *t = &trace[len - n + i];
+        if (i == 0) base = t->time - loaded[0].time;
+        native_event_t e = loaded[i];
+        e.time += base;
+        CHECK(same_event(&e, t, 0));
+    }
+    CHECK(base > 0);
+}
+
+/* dump is found among other console output */
+static void test_console_log(void)
+{
+    FILE *tmp = tmpfile();
+    fprintf(tmp, "Keyboard start.\n\n\t- Magic -\nr:\trecord dump\n");
+    fprintf(tmp, "record: %u %u 00010000 %u\n:", MATRIX_ROWS, (unsigned)sizeof(matrix_row_t),
+            (unsigned)(2 * (2 + sizeof(matrix_row_t))));
+    // row 0 col 0 down after 50ms and up after 30ms
+    fprintf(tmp, "0064%02X", 1);
+    for (uint8_t i = 1; i < sizeof(matrix_row_t); i++) fprintf(tmp, "00");
+    fprintf(tmp, "003C%02X", 0);
+    for (uint8_t i = 1; i < sizeof(matrix_row_t); i++) fprintf(tmp, "00");
+    fprintf(tmp, "\nrecord: 0 0 0 0\n");
+    rewind(tmp);
+
+    const native_event_t expected[] = {
+        PRESS(50, 0, 0),
+        RELEASE(80, 0, 0),
+    };
+    CHECK(native_record_load(tmp, loaded, TRACE_LEN(loaded), false) == 2);
+    CHECK(same_event(&loaded[0], &expected[0], 0));
+    CHECK(same_event(&loaded[1], &expected[1], 0));
+    fclose(tmp);
+
+    // dump of other matrix
+    tmp = tmpfile();
+    fprintf(tmp, "record: %u %u 00000000 0\n", MATRIX_ROWS + 1, (unsigned)sizeof(matrix_row_t));
+    rewind(tmp);
+    CHECK(native_record_load(tmp, loaded, TRACE_LEN(loaded), false) == -1);
+    fclose(tmp);
+
+    // cut short
+    tmp = tmpfile();
+    fprintf(tmp, "record: %u %u 00000000 8\n:006401\n", MATRIX_ROWS, (unsigned)sizeof(matrix_row_t));
+    rewind(tmp);
+    CHECK(native_record_load(tmp, loaded, TRACE_LEN(loaded), false) == -1);
+    fclose(tmp);
+}
+
+int main(void)
+{
+    test_rows();
+    test_events();
+    test_overflow();
+    test_console_log();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "keycode.h"
+#include "report.h"
+#include "action_code.h"
+#include "keymap.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+/* mapping before report.c tables, kept as reference */
+#define OLD_KEYCODE2SYSTEM(key) \
+    (key == KC_SYSTEM_POWER ? SYSTEM_POWER_DOWN : \
+    (key == KC_SYSTEM_SLEEP ? SYSTEM_SLEEP : \
+    (key == KC_SYSTEM_WAKE  ? SYSTEM_WAKE_UP : 0)))
+
+#define OLD_KEYCODE2CONSUMER(key) \
+    (key == KC_AUDIO_MUTE           ?  AUDIO_MUTE : \
+    (key == KC_AUDIO_VOL_UP         ?  AUDIO_VOL_UP : \
+    (key == KC_AUDIO_VOL_DOWN       ?  AUDIO_VOL_DOWN : \
+    (key == KC_MEDIA_NEXT_TRACK     ?  TRANSPORT_NEXT_TRACK : \
+    (key == KC_MEDIA_PREV_TRACK     ?  TRANSPORT_PREV_TRACK : \
+    (key == KC_MEDIA_FAST_FORWARD   ?  TRANSPORT_FAST_FORWARD : \
+    (key == KC_MEDIA_REWIND         ?  TRANSPORT_REWIND : \
+    (key == KC_MEDIA_STOP           ?  TRANSPORT_STOP : \
+    (key == KC_MEDIA_EJECT          ?  TRANSPORT_STOP_EJECT : \
+    (key == KC_MEDIA_PLAY_PAUSE     ?  TRANSPORT_PLAY_PAUSE : \
+    (key == KC_MEDIA_SELECT         ?  APPLAUNCH_CC_CONFIG : \
+    (key == KC_MAIL                 ?  APPLAUNCH_EMAIL : \
+    (key == KC_CALCULATOR           ?  APPLAUNCH_CALCULATOR : \
+    (key == KC_MY_COMPUTER          ?  APPLAUNCH_LOCAL_BROWSER : \
+    (key == KC_WWW_SEARCH           ?  APPCONTROL_SEARCH : \
+    (key == KC_WWW_HOME             ?  APPCONTROL_HOME : \
+    (key == KC_WWW_BACK             ?  APPCONTROL_BACK : \
+    (key == KC_WWW_FORWARD          ?  APPCONTROL_FORWARD : \
+    (key == KC_WWW_STOP             ?  APPCONTROL_STOP : \
+    (key == KC_WWW_REFRESH          ?  APPCONTROL_REFRESH : \
+    (key == KC_WWW_FAVORITES        ?  APPCONTROL_BOOKMARKS : 0)))))))))))))))))))))
+
+
+static void test_system(void)
+{
+    for (uint16_t k = 0; k <= 0xFF; k++) {
+        if (!IS_SYSTEM(k)) continue;
+        CHECK(KEYCODE2SYSTEM(k) == OLD_KEYCODE2SYSTEM(k));
+        CHECK(keymap_keycode_to_action(k).code == ((action_t)ACTION_USAGE_SYSTEM(OLD_KEYCODE2SYSTEM(k))).code);
+    }
+}
+
+static void test_consumer(void)
+{
+    for (uint16_t k = 0; k <= 0xFF; k++) {
+        if (!IS_CONSUMER(k)) continue;
+        // every keycode in range has usage
+        CHECK(KEYCODE2CONSUMER(k) != 0);
+        CHECK(keymap_keycode_to_action(k).code == ((action_t)ACTION_USAGE_CONSUMER(KEYCODE2CONSUMER(k))).code);
+        if (k <= KC_WWW_FAVORITES) {
+            CHECK(KEYCODE2CONSUMER(k) == OLD_KEYCODE2CONSUMER(k));
+        }
+    }
+    CHECK(KEYCODE2CONSUMER(KC_BRIGHTNESS_INC) == BRIGHTNESS_INCREMENT);
+    CHECK(KEYCODE2CONSUMER(KC_BRIGHTNESS_DEC) == BRIGHTNESS_DECREMENT);
+    // keycodes out of range are not consumer
+    CHECK(!IS_CONSUMER(KC_WWW_FAVORITES + 3));
+    CHECK(!IS_CONSUMER(KC_SYSTEM_WAKE));
+}
+
+int main(void)
+{
+    test_system();
+    test_consumer();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include "keycode.h"
+#include "report_desc.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+/* TMK LUFA boot keyboard, protocol/lufa/descriptor.c */
+static const uint8_t tmk_keyboard_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x08, 0x75, 0x01, 0x81, 0x02,
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x75, 0x01, 0x91, 0x0A,
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0xFF, 0x15, 0x00, 0x26, 0xFF, 0x00,
+    0x95, 0x06, 0x75, 0x08, 0x81, 0x00,
+    0xC0
+};
+
+/* TMK LUFA NKRO interface, bitmap of 248 keys with NKRO_EPSIZE 32 */
+static const uint8_t tmk_nkro_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x08, 0x75, 0x01, 0x81, 0x02,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x75, 0x01, 0x91, 0x0A,
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0xF7, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0xF8, 0x75, 0x01, 0x81, 0x02,
+    0xC0
+};
+
+/*
+ * Composite keyboard with report IDs: 6KRO on ID 1, consumer on ID 2 and
+ * NKRO bitmap of 0x04-0x73 on ID 3, which is not byte aligned. Modifiers are
+ * listed as Usages with Push/Pop and a vendor long item in between.
+ */
+static const uint8_t composite_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x85, 0x01,
+    0x05, 0x07, 0x09, 0xE0, 0x09, 0xE1, 0x09, 0xE2, 0x09, 0xE3,
+    0x09, 0xE4, 0x09, 0xE5, 0x09, 0xE6, 0x09, 0xE7,
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+    0xA4,                                       // Push
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x03,
+    0xB4,                                       // Pop
+    0xFE, 0x02, 0xF0, 0x12, 0x34,               // long item
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x03, 0x95, 0x03, 0x91, 0x02,
+    0x95, 0x05, 0x91, 0x03,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x91, 0x15, 0x00, 0x25, 0x91,   // logical max is negative
+    0x75, 0x08, 0x95, 0x06, 0x81, 0x00,
+    0xC0,
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01,
+    0x85, 0x02,
+    0x19, 0x00, 0x2A, 0x3C, 0x02, 0x15, 0x00, 0x26, 0x3C, 0x02,
+    0x75, 0x10, 0x95, 0x01, 0x81, 0x00,
+    0xC0,
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+    0x85, 0x03,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+    0x95, 0x04, 0x81, 0x03,                     // 4 bits padding
+    0x19, 0x04, 0x29, 0x73, 0x95, 0x70, 0x81, 0x02,
+    0x95, 0x04, 0x81, 0x03,
+    0xC0
+};
+
+/* mouse, no keyboard field */
+static const uint8_t mouse_desc[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F,
+    0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+    0xC0, 0xC0
+};
+
+
+/* feeds descriptor in pieces of control transfer packet */
+static bool parse(const uint8_t *desc, uint16_t len, hid_kbd_plan_t *plan)
+{
+    hid_desc_parser_t parser;
+    hid_desc_init(&parser, plan);
+    for (uint16_t i = 0; i < len; i += 8) {
+        hid_desc_feed(&parser, desc + i, (len - i < 8) ? len - i : 8);
+    }
+    return hid_desc_done(&parser);
+}
+
+static bool key(const uint8_t *keys, uint8_t code)
+{
+    return keys[code >> 3] & (1 << (code & 7));
+}
+
+static uint8_t key_count(const uint8_t *keys)
+{
+    uint8_t n = 0;
+    for (uint16_t i = 0; i < 256; i++) n += key(keys, i);
+    return n;
+}
+
+static void test_boot(void)
+{
+    hid_kbd_plan_t plan;
+    hid_kbd_plan_boot(&plan);
+    CHECK(plan.nfields == 2);
+    CHECK(!plan.has_report_id);
+    CHECK(plan.has_led);
+    CHECK(hid_kbd_rollover(&plan) == 6);
+
+    uint8_t keys[HID_KBD_BITMAP_SIZE] = {};
+    const uint8_t r1[8] = { 0x22, 0, KC_A, KC_Z, 0, 0, 0, 0 };
+    CHECK(hid_kbd_decode(&plan, r1, sizeof(r1), keys));
+    CHECK(key(keys, KC_LSHIFT) && key(keys, KC_RSHIFT));
+    CHECK(key(keys, KC_A) && key(keys, KC_Z));
+    CHECK(key_count(keys) == 4);
+
+    // keys are kept on rollover error and short report
+    const uint8_t r2[8] = { 0x02, 0, KC_ROLL_OVER, KC_ROLL_OVER, KC_ROLL_OVER, KC_ROLL_OVER, KC_ROLL_OVER, KC_ROLL_OVER };
+    CHECK(!hid_kbd_decode(&plan, r2, sizeof(r2), keys));
+    CHECK(!hid_kbd_decode(&plan, r1, 4, keys));
+    CHECK(key_count(keys) == 4);
+
+    const uint8_t r3[8] = { 0, 0, KC_Z, 0, 0, 0, 0, 0 };
+    CHECK(hid_kbd_decode(&plan, r3, sizeof(r3), keys));
+    CHECK(key(keys, KC_Z));
+    CHECK(key_count(keys) == 1);
+
+    // boot report longer than 8 bytes as some keyboards send
+    const uint8_t r4[16] = { 0 };
+    CHECK(hid_kbd_decode(&plan, r4, sizeof(r4), keys));
+    CHECK(key_count(keys) == 0);
+}
+
+static void test_tmk_keyboard(void)
+{
+    hid_kbd_plan_t plan;
+    hid_kbd_plan_t boot;
+    hid_kbd_plan_boot(&boot);
+    CHECK(parse(tmk_keyboard_desc, sizeof(tmk_keyboard_desc), &plan));
+    CHECK(plan.nfields == 2);
+    CHECK(hid_kbd_rollover(&plan) == 6);
+    // array covers all 256 usages
+    CHECK(plan.fields[1].usage_max == 0xFF);
+    CHECK(plan.fields[1].offset == 16);
+    CHECK(boot.fields[1].usage_max == 0x65);
+
+    uint8_t keys[HID_KBD_BITMAP_SIZE] = {};
+    const uint8_t r[8] = { 0x01, 0, KC_F13, KC_INT1, KC_LANG1, 0, 0, 0 };
+    CHECK(hid_kbd_decode(&plan, r, sizeof(r), keys));
+    CHECK(key(keys, KC_LCTRL) && key(keys, KC_F13) && key(keys, KC_INT1) && key(keys, KC_LANG1));
+    CHECK(key_count(keys) == 4);
+}
+
+static void test_tmk_nkro(void)
+{
+    hid_kbd_plan_t plan;
+    CHECK(parse(tmk_nkro_desc, sizeof(tmk_nkro_desc), &plan));
+    CHECK(plan.nfields == 2);
+    CHECK(plan.fields[1].offset == 8);
+    CHECK(plan.fields[1].count == 248);
+    CHECK(hid_kbd_rollover(&plan) == 248);
+
+    // all letters and modifiers at once
+    uint8_t report[32] = { 0xFF };
+    for (uint8_t k = KC_A; k <= KC_Z; k++) report[1 + k / 8] |= 1 << (k % 8);
+    uint8_t keys[HID_KBD_BITMAP_SIZE] = {};
+    CHECK(hid_kbd_decode(&plan, report, sizeof(report), keys));
+    CHECK(key_count(keys) == 26 + 8);
+    for (uint8_t k = KC_A; k <= KC_Z; k++) CHECK(key(keys, k));
+
+    // usages 0-3 in bitmap are not keys
+    memset(report, 0, sizeof(report));
+    report[1] = 0x0F | (1 << KC_A);
+    CHECK(hid_kbd_decode(&plan, report, sizeof(report), keys));
+    CHECK(key_count(keys) == 1 && key(keys, KC_A));
+}
+
+static void test_composite(void)
+{
+    hid_kbd_plan_t plan;
+    CHECK(parse(composite_desc, sizeof(composite_desc), &plan));
+    CHECK(plan.has_report_id);
+    CHECK(plan.has_led && plan.led_report_id == 1);
+    CHECK(plan.nfields == 4);
+    CHECK(hid_kbd_rollover(&plan) == 6 + 112);
+    // array of ID 1 is limited to usage maximum 0x91
+    CHECK(plan.fields[1].usage_max == 0x91);
+    CHECK(plan.fields[3].report_id == 3);
+    CHECK(plan.fields[3].offset == 12);
+    CHECK(plan.fields[3].usage_min == KC_A);
+
+    uint8_t keys[HID_KBD_BITMAP_SIZE] = {};
+    const uint8_t r1[9] = { 1, 0x01, 0, KC_A, KC_B, 0, 0, 0, 0 };
+    CHECK(hid_kbd_decode(&plan, r1, sizeof(r1), keys));
+    CHECK(key_count(keys) == 3);
+
+    // consumer report does not change keys
+    const uint8_t r2[3] = { 2, 0xE9, 0x00 };
+    CHECK(!hid_kbd_decode(&plan, r2, sizeof(r2), keys));
+    CHECK(key_count(keys) == 3);
+
+    // bitmap from bit 12: key of usage u at bit 12 + u - 4
+    uint8_t r3[1 + 16] = { 3, 0x02 };
+    uint8_t nkro[] = { KC_C, KC_Z, KC_SPACE, KC_F12, KC_KP_EQUAL, KC_F24 };
+    for (uint8_t i = 0; i < sizeof(nkro); i++) {
+        uint16_t bit = 12 + nkro[i] - KC_A;
+        r3[1 + bit / 8] |= 1 << (bit % 8);
+    }
+    CHECK(hid_kbd_decode(&plan, r3, sizeof(r3), keys));
+    CHECK(key(keys, KC_LSHIFT));
+    for (uint8_t i = 0; i < sizeof(nkro); i++) CHECK(key(keys, nkro[i]));
+    CHECK(key_count(keys) == 1 + sizeof(nkro));
+
+    // bitmap report releases all
+    memset(r3 + 1, 0, sizeof(r3) - 1);
+    CHECK(hid_kbd_decode(&plan, r3, sizeof(r3), keys));
+    CHECK(key_count(keys) == 0);
+}
+
+static void test_not_keyboard(void)
+{
+    hid_kbd_plan_t plan;
+    CHECK(!parse(mouse_desc, sizeof(mouse_desc), &plan));
+    CHECK(plan.nfields == 0);
+
+    // truncated in middle of item
+    CHECK(!parse(tmk_keyboard_desc, sizeof(tmk_keyboard_desc) - 2, &plan));
+
+    // Pop without Push
+    const uint8_t pop[] = { 0x05, 0x07, 0xB4, 0x19, 0x00, 0x29, 0x65, 0x75, 0x08, 0x95, 0x06, 0x81, 0x00 };
+    CHECK(!parse(pop, sizeof(pop), &plan));
+}
+
+int main(void)
+{
+    test_boot();
+    test_tmk_keyboard();
+    test_tmk_nkro();
+    test_composite();
+    test_not_keyboard();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include "keyboard.h"
+#include "keycode.h"
+#include "native.h"
+#include "keymap_native.h"
+#include "test.h"
+
+#ifndef MATRIX_SCAN_IDLE_TIMEOUT
+#   error "test_scan_idle: build with MATRIX_SCAN_IDLE_TIMEOUT"
+#endif
+
+
+int test_failures = 0;
+
+
+/* first keyboard report which has the key */
+static const native_report_t *find_key(uint8_t key)
+{
+    for (uint16_t i = 0; i < native_report_count(); i++) {
+        if (test_report_has(test_keyboard_report(i), key)) return native_report_get(i);
+    }
+    return NULL;
+}
+
+static void test_idle(void)
+{
+    native_run(NULL, 0, MATRIX_SCAN_IDLE_TIMEOUT - 100);
+    CHECK(keyboard_scan_idle_count() == 0);
+    native_run(NULL, 0, MATRIX_SCAN_IDLE_TIMEOUT + 100);
+    CHECK(keyboard_scan_idle_count() == 1);
+
+    // main loop sleeps until next timer tick while idle
+    uint32_t scans = native_scan_count();
+    native_run(NULL, 0, MATRIX_SCAN_IDLE_TIMEOUT + 1100);
+    CHECK(native_scan_count() - scans <= 1000 / 2);
+}
+
+/* first key after idle is late by idle interval at most, next one is not */
+static void test_wake(void)
+{
+    const uint32_t start = 3 * MATRIX_SCAN_IDLE_TIMEOUT + 3;
+    const native_event_t typing[] = {
+        PRESS(start, POS_A),
+        RELEASE(start + 30, POS_A),
+        PRESS(start + 40, POS_B),
+        RELEASE(start + 70, POS_B),
+    };
+    native_report_clear();
+    native_run(typing, TRACE_LEN(typing), start + 100);
+
+    const native_report_t *a = find_key(KC_A);
+    CHECK(a != NULL);
+    if (a) {
+        CHECK(a->time >= start * 1000UL);
+        CHECK(a->time <= (start + MATRIX_SCAN_IDLE_INTERVAL) * 1000UL);
+    }
+    CHECK(keyboard_scan_wake_count() == 1);
+
+    const native_report_t *b = find_key(KC_B);
+    CHECK(b != NULL);
+    if (b) CHECK(b->time == (start + 40) * 1000UL);
+
+    // idle again after the last release
+    native_run(NULL, 0, start + 70 + MATRIX_SCAN_IDLE_TIMEOUT + 100);
+    CHECK(keyboard_scan_idle_count() == 2);
+    CHECK(keyboard_scan_wake_count() == 1);
+}
+
+int main(void)
+{
+    native_init();
+
+    test_idle();
+    test_wake();
+
+    return TEST_RESULT();
+}
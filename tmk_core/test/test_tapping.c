@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keycode.h"
+#include "action.h"
+#include "action_tapping.h"
+#include "native.h"
+#include "keymap_native.h"
+#include "test.h"
+
+
+int test_failures = 0;
+
+
+/* keys of row 2 and A, all but A are transparent on layer 1 */
+static const uint8_t typed_pos[][2] = {
+    { POS_A }, { 2, 0 }, { 2, 1 }, { 2, 2 }, { 2, 3 }, { 2, 4 }, { 2, 5 }, { 2, 6 }, { 2, 7 },
+};
+static const uint8_t typed_code[] = {
+    KC_A, KC_I, KC_J, KC_K, KC_L, KC_M, KC_N, KC_O, KC_P,
+};
+#define TYPED_KEYS  (sizeof(typed_code))
+
+/* 30 keys/s, each held longer than interval so that keys roll over */
+#define TYPE_INTERVAL   33
+#define TYPE_HOLD       50
+#define TYPE_COUNT      58
+
+/* mods tap key has shorter term than TAPPING_TERM */
+#define MODS_TAP_TERM   100
+
+static native_event_t trace[TYPE_COUNT * 2 + 64];
+static uint16_t trace_len;
+static uint16_t appear[256];
+
+
+uint16_t action_get_tapping_term(keyrecord_t *record, action_t action)
+{
+    (void)record;
+    switch (action.kind.id) {
+        case ACT_LMODS_TAP:
+        case ACT_RMODS_TAP:
+            return MODS_TAP_TERM;
+    }
+    return TAPPING_TERM;
+}
+
+static void add_event(uint32_t time, uint8_t row, uint8_t col, bool pressed)
+{
+    trace[trace_len++] = (native_event_t){ .time = time, .row = row, .col = col, .pressed = pressed };
+}
+
+static int compare_time(const void *a, const void *b)
+{
+    const native_event_t *x = a, *y = b;
+    return (x->time > y->time) - (x->time < y->time);
+}
+
+/* counts how many times each key appears in reports */
+static void count_appear(void)
+{
+    const report_keyboard_t *prev = NULL;
+    memset(appear, 0, sizeof(appear));
+    for (uint16_t i = 0; i < native_report_count(); i++) {
+        const report_keyboard_t *r = test_keyboard_report(i);
+        if (!r) continue;
+        for (uint16_t key = 1; key < 256; key++) {
+            if (test_report_has(r, key) && !test_report_has(prev, key)) appear[key]++;
+        }
+        prev = r;
+    }
+}
+
+/* holds layer tap key while typing: all typed in buffer resolve on layer 1 */
+static void test_hold_while_typing(void)
+{
+    const uint32_t start = 1000;
+    uint16_t typed[TYPED_KEYS] = {};
+
+    trace_len = 0;
+    add_event(start, POS_LT1_SPC, true);
+    for (uint16_t i = 0; i < TYPE_COUNT; i++) {
+        uint8_t k = i % TYPED_KEYS;
+        uint32_t t = start + 50 + i * TYPE_INTERVAL;
+        add_event(t, typed_pos[k][0], typed_pos[k][1], true);
+        add_event(t + TYPE_HOLD, typed_pos[k][0], typed_pos[k][1], false);
+        typed[k]++;
+    }
+    add_event(start + 2000, POS_LT1_SPC, false);
+    qsort(trace, trace_len, sizeof(trace[0]), compare_time);
+
+    native_report_clear();
+    native_run(trace, trace_len, start + 3000);
+    count_appear();
+
+    CHECK(appear[KC_A] == 0);
+    CHECK(appear[KC_1] == typed[0]);
+    for (uint8_t k = 1; k < TYPED_KEYS; k++) {
+        CHECK(appear[typed_code[k]] == typed[k]);
+    }
+    CHECK(appear[KC_SPC] == 0);
+    CHECK(test_report_empty(test_keyboard_report(native_report_count() - 1)));
+}
+
+/* taps layer tap key among typing: each tap gives space */
+static void test_tap_while_typing(void)
+{
+    const uint32_t start = 5000;
+    uint16_t typed[TYPED_KEYS] = {};
+    uint16_t taps = 0;
+
+    trace_len = 0;
+    for (uint16_t i = 0; i < TYPE_COUNT; i++) {
+        uint8_t k = 1 + i % (TYPED_KEYS - 1);
+        uint32_t t = start + i * TYPE_INTERVAL;
+        add_event(t, typed_pos[k][0], typed_pos[k][1], true);
+        add_event(t + TYPE_HOLD, typed_pos[k][0], typed_pos[k][1], false);
+        typed[k]++;
+        // tap interrupted by next key
+        if (i % 6 == 0 && i + 1 < TYPE_COUNT) {
+            add_event(t + 10, POS_LT1_SPC, true);
+            add_event(t + 40, POS_LT1_SPC, false);
+            taps++;
+        }
+    }
+    qsort(trace, trace_len, sizeof(trace[0]), compare_time);
+
+    native_report_clear();
+    native_run(trace, trace_len, start + 3000);
+    count_appear();
+
+    CHECK(appear[KC_SPC] == taps);
+    for (uint8_t k = 1; k < TYPED_KEYS; k++) {
+        CHECK(appear[typed_code[k]] == typed[k]);
+    }
+    CHECK(test_report_empty(test_keyboard_report(native_report_count() - 1)));
+}
+
+/* first keyboard report which has the key */
+static const native_report_t *find_key(uint8_t key)
+{
+    for (uint16_t i = 0; i < native_report_count(); i++) {
+        if (test_report_has(test_keyboard_report(i), key)) return native_report_get(i);
+    }
+    return NULL;
+}
+
+static void test_tapping_term(void)
+{
+    // tap within term of mods tap key
+    const native_event_t tap[] = {
+        PRESS(8000, POS_LCTL_ESC),
+        RELEASE(8000 + MODS_TAP_TERM - 20, POS_LCTL_ESC),
+    };
+    native_report_clear();
+    native_run(tap, TRACE_LEN(tap), 8500);
+    CHECK(find_key(KC_ESC) != NULL);
+
+    // held over its term though still within TAPPING_TERM
+    const native_event_t hold[] = {
+        PRESS(9000, POS_LCTL_ESC),
+        RELEASE(9000 + MODS_TAP_TERM + 20, POS_LCTL_ESC),
+    };
+    native_report_clear();
+    native_run(hold, TRACE_LEN(hold), 9500);
+    CHECK(find_key(KC_ESC) == NULL);
+    CHECK(native_report_count() == 2);
+    CHECK(test_keyboard_report(0)->mods == MOD_BIT(KC_LCTL));
+    CHECK(native_report_get(0)->time == (9000 + MODS_TAP_TERM) * 1000UL);
+    CHECK(test_report_empty(test_keyboard_report(1)));
+}
+
+/* other key typed while mods tap key is down */
+static void test_permissive_hold(void)
+{
+    const native_event_t typing[] = {
+        PRESS(10000, POS_LCTL_ESC),
+        PRESS(10020, POS_A),
+        RELEASE(10060, POS_A),
+        RELEASE(10090, POS_LCTL_ESC),
+    };
+    native_report_clear();
+    native_run(typing, TRACE_LEN(typing), 10500);
+
+    const native_report_t *a = find_key(KC_A);
+    CHECK(a != NULL);
+    if (!a) return;
+#ifdef PERMISSIVE_HOLD
+    // Ctrl+A as soon as A is released
+    CHECK(a->keyboard.mods == MOD_BIT(KC_LCTL));
+    CHECK(a->time == 10060 * 1000UL);
+    CHECK(find_key(KC_ESC) == NULL);
+#else
+    // not before the tap key is released
+    CHECK(a->time >= 10090 * 1000UL);
+#endif
+    CHECK(test_report_empty(test_keyboard_report(native_report_count() - 1)));
+}
+
+int main(void)
+{
+    native_init();
+
+    test_hold_while_typing();
+    test_tap_while_typing();
+    test_tapping_term();
+    test_permissive_hold();
+
+    return TEST_RESULT();
+}
@@ -1,11 +1,14 @@
 COMMON_DIR = $(TMK_DIR)/common
 SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/keyboard.c \
+	$(COMMON_DIR)/keyevent_queue.c \
+	$(COMMON_DIR)/debounce.c \
 	$(COMMON_DIR)/action.c \
 	$(COMMON_DIR)/action_tapping.c \
 	$(COMMON_DIR)/action_macro.c \
 	$(COMMON_DIR)/action_layer.c \
 	$(COMMON_DIR)/action_util.c \
+	$(COMMON_DIR)/report.c \
 	$(COMMON_DIR)/keymap.c \
 	$(COMMON_DIR)/print.c \
 	$(COMMON_DIR)/debug.c \
@@ -65,6 +68,24 @@ ifdef BACKLIGHT_ENABLE
     OPT_DEFS += -DBACKLIGHT_ENABLE
 endif
 
+ifdef MATRIX_SCAN_ISR_ENABLE
+    OPT_DEFS += -DMATRIX_SCAN_ISR_ENABLE
+endif
+
+ifdef KEYBOARD_PROFILE_ENABLE
+    SRC += $(COMMON_DIR)/keyboard_profile.c
+    OPT_DEFS += -DKEYBOARD_PROFILE_ENABLE
+endif
+
+ifdef KEYBOARD_RECORD_ENABLE
+    SRC += $(COMMON_DIR)/keyboard_record.c
+    OPT_DEFS += -DKEYBOARD_RECORD_ENABLE
+endif
+
+ifdef LAYER_CACHE_ENABLE
+    OPT_DEFS += -DLAYER_CACHE_ENABLE
+endif
+
 ifdef KEYMAP_SECTION_ENABLE
     OPT_DEFS += -DKEYMAP_SECTION_ENABLE
 
@@ -0,0 +1,156 @@
+/*
+ * Keymap compiler
+ *
+ * Built for host with keymap source of keyboard and mapping module of
+ * tmk_core(keymap.c, actionmap.c or unimap.c), then prints C source of
+ * tables resolved from the keymap. See keymap_compile.mk.
+ *
+ * -a   action of each layer and key, flattened for keymap_flat.c, and bits
+ *      of keys whose action is keycode of keymap(KEYMAP_COMPILE_ENABLE)
+ * -m   mask of layers which have non-transparent action on each key
+ *      (LAYER_MASK_ENABLE)
+ *
+ * Flash size of tables is reported on stderr.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "keyboard.h"
+#include "keycode.h"
+#include "action.h"
+#include "keymap.h"
+
+/* keymap source which defines keymaps[] or actionmaps[] */
+#include KEYMAP_COMPILE_KEYMAP
+
+#ifdef ACTIONMAP_ENABLE
+#   define KEYMAP_LAYERS   (sizeof(actionmaps) / sizeof(actionmaps[0]))
+#   define KEYMAP_SIZE     sizeof(actionmaps[0])
+#else
+#   define KEYMAP_LAYERS   (sizeof(keymaps) / sizeof(keymaps[0]))
+#   define KEYMAP_SIZE     sizeof(keymaps[0])
+#endif
+
+
+/* action of key as resolved by firmware, except for keycodes which act
+ * when resolved, those are left to keymap_flat.c as plain key action */
+static action_t resolve(uint8_t layer, uint8_t row, uint8_t col)
+{
+    keypos_t key = { .row = row, .col = col };
+#ifndef ACTIONMAP_ENABLE
+    uint8_t keycode = keymap_key_to_keycode(layer, key);
+    if (keycode == KC_BOOTLOADER) {
+        return (action_t)ACTION_KEY(keycode);
+    }
+#endif
+    return action_for_key(layer, key);
+}
+
+#ifndef ACTIONMAP_ENABLE
+/* whether action is plain keycode of keymap, not one from fn_actions */
+static bool is_keycode(uint8_t layer, uint8_t row, uint8_t col)
+{
+    keypos_t key = { .row = row, .col = col };
+    uint8_t keycode = keymap_key_to_keycode(layer, key);
+    if (keycode >= KC_FN0 && keycode <= KC_FN31) return false;
+    return resolve(layer, row, col).code == keycode;
+}
+
+static void print_keycodes(uint8_t layers)
+{
+    printf("const uint8_t PROGMEM keymap_compiled_keycodes[][MATRIX_ROWS][(MATRIX_COLS + 7) / 8] = {\n");
+    for (uint8_t l = 0; l < layers; l++) {
+        printf("    [%u] = {\n", l);
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+            printf("        {");
+            for (uint8_t c = 0; c < MATRIX_COLS; c += 8) {
+                uint8_t bits = 0;
+                for (uint8_t i = 0; i < 8 && c + i < MATRIX_COLS; i++) {
+                    if (is_keycode(l, r, c + i)) bits |= 1<<i;
+                }
+                printf("%s0x%02X", c ? ", " : " ", bits);
+            }
+            printf(" },\n");
+        }
+        printf("    },\n");
+    }
+    printf("};\n\n");
+
+    fprintf(stderr, "keymap_compile: keycode bits %u bytes\n",
+            (unsigned)(layers * MATRIX_ROWS * ((MATRIX_COLS + 7) / 8)));
+}
+#endif
+
+static void print_actions(uint8_t layers)
+{
+    printf("const uint8_t PROGMEM keymap_compiled_layers = %u;\n\n", layers);
+    printf("const action_t PROGMEM keymap_compiled_actions[][MATRIX_ROWS][MATRIX_COLS] = {\n");
+    for (uint8_t l = 0; l < layers; l++) {
+        printf("    [%u] = {\n", l);
+        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+            printf("        {");
+            for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+                printf("%s{ .code = 0x%04X }", c ? ", " : " ", resolve(l, r, c).code);
+            }
+            printf(" },\n");
+        }
+        printf("    },\n");
+    }
+    printf("};\n\n");
+
+    fprintf(stderr, "keymap_compile: %u layers, %u bytes/layer(keymap: %u bytes/layer), %u bytes total\n",
+            layers, (unsigned)(MATRIX_ROWS * MATRIX_COLS * sizeof(action_t)), (unsigned)KEYMAP_SIZE,
+            (unsigned)(layers * MATRIX_ROWS * MATRIX_COLS * sizeof(action_t)));
+}
+
+static void print_mask(uint8_t layers)
+{
+    printf("const uint32_t PROGMEM layer_mask[MATRIX_ROWS][MATRIX_COLS] = {\n");
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        printf("    {");
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            uint32_t mask = 0;
+            for (uint8_t l = 0; l < layers; l++) {
+                if (resolve(l, r, c).code != (action_t)ACTION_TRANSPARENT.code) {
+                    mask |= 1UL<<l;
+                }
+            }
+            printf("%s0x%08lX", c ? ", " : " ", (unsigned long)mask);
+        }
+        printf(" },\n");
+    }
+    printf("};\n\n");
+
+    fprintf(stderr, "keymap_compile: layer mask %u bytes\n",
+            (unsigned)(MATRIX_ROWS * MATRIX_COLS * sizeof(uint32_t)));
+}
+
+int main(int argc, char *argv[])
+{
+    bool actions = false, mask = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-a")) {
+            actions = true;
+        } else if (!strcmp(argv[i], "-m")) {
+            mask = true;
+        } else {
+            fprintf(stderr, "usage: %s [-a] [-m]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    uint8_t layers = KEYMAP_LAYERS < 32 ? KEYMAP_LAYERS : 32;
+
+    printf("/* generated by tool/keymap_compile from %s, %u layers */\n", KEYMAP_COMPILE_KEYMAP, layers);
+    printf("#include <stdint.h>\n");
+    printf("#include \"progmem.h\"\n");
+    printf("#include \"action.h\"\n\n");
+    if (actions) {
+        print_actions(layers);
+#ifndef ACTIONMAP_ENABLE
+        print_keycodes(layers);
+#endif
+    }
+    if (mask) print_mask(layers);
+    return 0;
+}
@@ -0,0 +1,33 @@
+# Generates tables from keymap at build time, see keymap_compile.c.
+#
+# Keymap source is first of SRC with 'map' in its name, e.g. keymap_hasu.c
+# or unimap_hasu.c. Set KEYMAP_COMPILE_KEYMAP when it is named otherwise.
+
+KEYMAP_COMPILE_DIR = $(TMK_DIR)/tool/keymap_compile
+# OBJDIR of rules.mk is not defined yet here
+KEYMAP_COMPILE_C := obj_$(TARGET)/keymap_compiled.c
+KEYMAP_COMPILE_KEYMAP ?= $(firstword $(filter-out $(COMMON_DIR)/% $(KEYMAP_COMPILE_C), \
+			$(foreach f,$(SRC),$(if $(findstring map,$(notdir $(f))),$(f)))))
+# mapping module of tmk_core which provides action_for_key()
+KEYMAP_COMPILE_MAP = $(filter $(COMMON_DIR)/keymap.c $(COMMON_DIR)/actionmap.c $(COMMON_DIR)/unimap.c,$(SRC))
+KEYMAP_COMPILE_OPTS = $(if $(filter yes,$(strip $(KEYMAP_COMPILE_ENABLE))),-a) \
+		      $(if $(filter yes,$(strip $(LAYER_MASK_ENABLE))),-m)
+
+HOSTCC ?= gcc
+
+SRC += $(KEYMAP_COMPILE_C)
+
+# rule below should not be default goal of including makefile
+KEYMAP_COMPILE_GOAL := $(.DEFAULT_GOAL)
+
+# functions called from keymap are never run by compiler, firmware API they
+# call is linked from keymap_compile_stub.c
+$(KEYMAP_COMPILE_C): $(KEYMAP_COMPILE_DIR)/keymap_compile.c $(KEYMAP_COMPILE_KEYMAP) $(KEYMAP_COMPILE_MAP) $(TMK_DIR)/common/report.c $(KEYMAP_COMPILE_DIR)/keymap_compile_stub.c $(CONFIG_H)
+	@mkdir -p $(@D)
+	$(HOSTCC) -DPROTOCOL_NATIVE $(filter -DUNIMAP_ENABLE -DACTIONMAP_ENABLE,$(OPT_DEFS)) \
+		-I$(TARGET_DIR) -I$(TMK_DIR) -I$(TMK_DIR)/common -include $(CONFIG_H) \
+		-DKEYMAP_COMPILE_KEYMAP='"$(word 2,$^)"' \
+		$< $(word 3,$^) $(word 4,$^) $(word 5,$^) -o $(@D)/keymap_compile
+	$(@D)/keymap_compile $(KEYMAP_COMPILE_OPTS) > $@.tmp && mv $@.tmp $@
+
+.DEFAULT_GOAL := $(KEYMAP_COMPILE_GOAL)
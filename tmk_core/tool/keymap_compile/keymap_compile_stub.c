@@ -0,0 +1,96 @@
+/*
+ * Firmware API for keymap_compile
+ *
+ * Functions of keymap like action_function() or macros call these at run time
+ * of firmware and never while tables are generated. They are linked to let
+ * the keymap build on host, any other symbol keymap needs is reported by
+ * linker. Calling one of these stops keymap_compile with its name.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "keyboard.h"
+#include "action.h"
+#include "action_util.h"
+#include "action_layer.h"
+#include "action_macro.h"
+#include "host.h"
+#include "timer.h"
+#include "debug.h"
+#include "bootloader.h"
+
+
+uint32_t default_layer_state = 0;
+uint32_t layer_state = 0;
+debug_config_t debug_config;
+
+static void stub(const char *name) __attribute__ ((noreturn));
+static void stub(const char *name)
+{
+    fprintf(stderr, "keymap_compile: %s() is called while generating tables\n", name);
+    exit(1);
+}
+
+#define STUB(name, ...) name(__VA_ARGS__) { stub(#name); }
+
+/* action.h */
+void STUB(action_exec, keyevent_t event)
+void STUB(process_action, keyrecord_t *record)
+void STUB(register_code, uint8_t code)
+void STUB(unregister_code, uint8_t code)
+void STUB(register_mods, uint8_t mods)
+void STUB(unregister_mods, uint8_t mods)
+void STUB(clear_keyboard, void)
+void STUB(clear_keyboard_but_mods, void)
+void STUB(layer_switch, uint8_t new_layer)
+bool STUB(is_tap_key, keyevent_t event)
+
+/* action_util.h */
+void STUB(send_keyboard_report, void)
+void STUB(add_key, uint8_t key)
+void STUB(del_key, uint8_t key)
+void STUB(clear_keys, void)
+uint8_t STUB(has_anykey, void)
+uint8_t STUB(has_anymod, void)
+uint8_t STUB(get_first_key, void)
+uint8_t STUB(get_mods, void)
+void STUB(add_mods, uint8_t mods)
+void STUB(del_mods, uint8_t mods)
+void STUB(set_mods, uint8_t mods)
+void STUB(clear_mods, void)
+uint8_t STUB(get_weak_mods, void)
+void STUB(add_weak_mods, uint8_t mods)
+void STUB(del_weak_mods, uint8_t mods)
+void STUB(set_weak_mods, uint8_t mods)
+void STUB(clear_weak_mods, void)
+void STUB(set_oneshot_mods, uint8_t mods)
+void STUB(clear_oneshot_mods, void)
+
+/* action_layer.h */
+void STUB(default_layer_set, uint32_t state)
+void STUB(layer_clear, void)
+void STUB(layer_move, uint8_t layer)
+void STUB(layer_on, uint8_t layer)
+void STUB(layer_off, uint8_t layer)
+void STUB(layer_invert, uint8_t layer)
+void STUB(layer_or, uint32_t state)
+void STUB(layer_and, uint32_t state)
+void STUB(layer_xor, uint32_t state)
+
+/* action_macro.h */
+void STUB(action_macro_play, const macro_t *macro_p)
+
+/* host.h */
+uint8_t STUB(host_keyboard_leds, void)
+void STUB(host_system_send, uint16_t data)
+void STUB(host_consumer_send, uint16_t data)
+
+/* timer.h, wait.h */
+uint16_t STUB(timer_read, void)
+uint32_t STUB(timer_read32, void)
+uint16_t STUB(timer_elapsed, uint16_t last)
+uint32_t STUB(timer_elapsed32, uint32_t last)
+void STUB(timer_advance_us, uint32_t us)
+
+/* bootloader.h */
+void STUB(bootloader_jump, void)
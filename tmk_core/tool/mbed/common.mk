@@ -4,9 +4,11 @@ OBJECTS += \
 	$(OBJDIR)/common/action_macro.o \
 	$(OBJDIR)/common/action_layer.o \
 	$(OBJDIR)/common/action_util.o \
+	$(OBJDIR)/common/report.o \
 	$(OBJDIR)/common/host.o \
 	$(OBJDIR)/common/keymap.o \
 	$(OBJDIR)/common/keyboard.o \
+	$(OBJDIR)/common/keyevent_queue.o \
 	$(OBJDIR)/common/print.o \
 	$(OBJDIR)/common/debug.o \
 	$(OBJDIR)/common/util.o \
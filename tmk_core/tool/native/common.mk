@@ -0,0 +1,126 @@
+COMMON_DIR = common
+SRC +=	$(COMMON_DIR)/host.c \
+	$(COMMON_DIR)/keyboard.c \
+	$(COMMON_DIR)/keyevent_queue.c \
+	$(COMMON_DIR)/matrix.c \
+	$(COMMON_DIR)/debounce.c \
+	$(COMMON_DIR)/action.c \
+	$(COMMON_DIR)/action_tapping.c \
+	$(COMMON_DIR)/action_macro.c \
+	$(COMMON_DIR)/action_layer.c \
+	$(COMMON_DIR)/action_util.c \
+	$(COMMON_DIR)/report.c \
+	$(COMMON_DIR)/print.c \
+	$(COMMON_DIR)/debug.c \
+	$(COMMON_DIR)/util.c \
+	$(COMMON_DIR)/hook.c \
+	$(COMMON_DIR)/native/suspend.c \
+	$(COMMON_DIR)/native/timer.c \
+	$(COMMON_DIR)/native/bootloader.c
+
+
+# Option modules
+ifeq (yes,$(strip $(UNIMAP_ENABLE)))
+    SRC += $(COMMON_DIR)/unimap.c
+    OPT_DEFS += -DUNIMAP_ENABLE
+    OPT_DEFS += -DACTIONMAP_ENABLE
+else
+    ifeq (yes,$(strip $(ACTIONMAP_ENABLE)))
+	SRC += $(COMMON_DIR)/actionmap.c
+	OPT_DEFS += -DACTIONMAP_ENABLE
+    else
+	SRC += $(COMMON_DIR)/keymap.c
+    endif
+endif
+
+ifeq (yes,$(strip $(BOOTMAGIC_ENABLE)))
+    SRC += $(COMMON_DIR)/bootmagic.c
+    SRC += $(COMMON_DIR)/native/eeconfig.c
+    OPT_DEFS += -DBOOTMAGIC_ENABLE
+endif
+
+ifeq (yes,$(strip $(MOUSEKEY_ENABLE)))
+    SRC += $(COMMON_DIR)/mousekey.c
+    OPT_DEFS += -DMOUSEKEY_ENABLE
+    OPT_DEFS += -DMOUSE_ENABLE
+endif
+
+ifeq (yes,$(strip $(EXTRAKEY_ENABLE)))
+    OPT_DEFS += -DEXTRAKEY_ENABLE
+endif
+
+ifeq (yes,$(strip $(CONSOLE_ENABLE)))
+    OPT_DEFS += -DCONSOLE_ENABLE
+else
+    OPT_DEFS += -DNO_PRINT
+    OPT_DEFS += -DNO_DEBUG
+endif
+
+ifeq (yes,$(strip $(COMMAND_ENABLE)))
+    SRC += $(COMMON_DIR)/command.c
+    OPT_DEFS += -DCOMMAND_ENABLE
+endif
+
+ifeq (yes,$(strip $(NKRO_ENABLE)))
+    OPT_DEFS += -DNKRO_ENABLE
+endif
+
+ifeq (yes,$(strip $(USB_6KRO_ENABLE)))
+    OPT_DEFS += -DUSB_6KRO_ENABLE
+endif
+
+ifeq (yes, $(strip $(KEYBOARD_LOCK_ENABLE)))
+    OPT_DEFS += -DKEYBOARD_LOCK_ENABLE
+endif
+
+ifeq (yes,$(strip $(SLEEP_LED_ENABLE)))
+    $(error SLEEP_LED_ENABLE: Not Supported)
+endif
+
+ifeq (yes,$(strip $(BACKLIGHT_ENABLE)))
+    SRC += $(COMMON_DIR)/backlight.c
+    OPT_DEFS += -DBACKLIGHT_ENABLE
+endif
+
+ifeq (yes,$(strip $(MATRIX_SCAN_ISR_ENABLE)))
+    OPT_DEFS += -DMATRIX_SCAN_ISR_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYBOARD_PROFILE_ENABLE)))
+    SRC += $(COMMON_DIR)/keyboard_profile.c
+    OPT_DEFS += -DKEYBOARD_PROFILE_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYBOARD_RECORD_ENABLE)))
+    SRC += $(COMMON_DIR)/keyboard_record.c
+    OPT_DEFS += -DKEYBOARD_RECORD_ENABLE
+endif
+
+ifeq (yes,$(strip $(LAYER_CACHE_ENABLE)))
+    OPT_DEFS += -DLAYER_CACHE_ENABLE
+endif
+
+ifeq (yes,$(strip $(LAYER_MASK_ENABLE)))
+    OPT_DEFS += -DLAYER_MASK_ENABLE
+endif
+
+ifeq (yes,$(strip $(KEYMAP_COMPILE_ENABLE)))
+    SRC += $(COMMON_DIR)/keymap_flat.c
+    OPT_DEFS += -DKEYMAP_COMPILE_ENABLE
+endif
+
+ifneq (,$(filter yes,$(strip $(LAYER_MASK_ENABLE)) $(strip $(KEYMAP_COMPILE_ENABLE))))
+    include $(TMK_DIR)/tool/keymap_compile/keymap_compile.mk
+endif
+
+ifeq (yes,$(strip $(KEYMAP_SECTION_ENABLE)))
+    $(error KEYMAP_SECTION_ENABLE: Not Supported)
+endif
+
+# Version string
+VERSION := $(shell (git describe --always --dirty || echo 'unknown') 2> /dev/null)
+OPT_DEFS += -DVERSION=$(VERSION)
+
+
+# Search Path
+VPATH += $(TMK_DIR)/common
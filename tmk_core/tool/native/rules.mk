@@ -0,0 +1,125 @@
+# Hey Emacs, this is a -*- makefile -*-
+#----------------------------------------------------------------------------
+# Build rules for host-native simulation
+#
+# On command line:
+#
+# make all = Build programs listed in PROGRAMS.
+#
+# make test = Build and run all programs, fails when any of them fails.
+#             Utilities listed in TOOLS are built but not run.
+#
+# make bench = Build and run benchmarks listed in BENCHES.
+#
+# make clean = Clean out built project files.
+#
+# Each program in PROGRAMS is built from <program>.c or <program>.cpp, which
+# has main(), and objects of SRC shared among programs.
+#----------------------------------------------------------------------------
+
+# Object files directory
+OBJDIR = obj_$(TARGET)
+
+# Optimization level
+OPT = 2
+
+CSTANDARD = -std=gnu99
+
+CDEFS = $(OPT_DEFS)
+
+EXTRAINCDIRS = $(subst :, ,$(VPATH))
+
+CFLAGS = -g
+CFLAGS += $(CDEFS)
+CFLAGS += -O$(OPT)
+CFLAGS += -funsigned-char
+CFLAGS += -funsigned-bitfields
+CFLAGS += -fno-strict-aliasing
+CFLAGS += -Wall
+CFLAGS += -Wstrict-prototypes
+CFLAGS += -Wno-format
+CFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
+CFLAGS += $(CSTANDARD)
+ifdef CONFIG_H
+    CFLAGS += -include $(CONFIG_H)
+endif
+
+CPPFLAGS = -g
+CPPFLAGS += $(CDEFS)
+CPPFLAGS += -O$(OPT)
+CPPFLAGS += -funsigned-char
+CPPFLAGS += -funsigned-bitfields
+CPPFLAGS += -fno-strict-aliasing
+CPPFLAGS += -fno-exceptions
+CPPFLAGS += -Wall
+CPPFLAGS += -Wno-format
+CPPFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
+ifdef CONFIG_H
+    CPPFLAGS += -include $(CONFIG_H)
+endif
+
+LDFLAGS = -lm
+LDFLAGS += $(EXTRALDFLAGS)
+
+# You can give extra flags at 'make' command line like: make EXTRAFLAGS=-DFOO=bar
+ALL_CFLAGS = $(CFLAGS) $(GENDEPFLAGS) $(EXTRAFLAGS)
+ALL_CPPFLAGS = $(CPPFLAGS) $(GENDEPFLAGS) $(EXTRAFLAGS)
+
+GENDEPFLAGS = -MMD -MP -MF .dep/$(subst /,_,$@).d
+
+CC = gcc
+CXX = g++
+REMOVE = rm -f
+REMOVEDIR = rm -rf
+
+
+OBJ = $(patsubst %.c,$(OBJDIR)/%.o,$(patsubst %.cpp,$(OBJDIR)/%.o,$(SRC)))
+
+# C++ objects are linked with C++ runtime
+ifneq (,$(filter %.cpp,$(SRC)))
+    LD = $(CXX)
+else
+    LD = $(CC)
+endif
+PROGRAM_BIN = $(addprefix $(OBJDIR)/,$(PROGRAMS))
+BENCH_BIN = $(addprefix $(OBJDIR)/,$(BENCHES))
+TOOL_BIN = $(addprefix $(OBJDIR)/,$(TOOLS))
+
+
+all: $(PROGRAM_BIN) $(BENCH_BIN) $(TOOL_BIN)
+
+test: all
+	@for p in $(PROGRAM_BIN); do \
+		echo "==== $$p"; \
+		./$$p || exit 1; \
+	done
+
+bench: all
+	@for p in $(BENCH_BIN); do \
+		echo "==== $$p"; \
+		./$$p || exit 1; \
+	done
+
+.PRECIOUS : $(OBJ)
+$(OBJDIR)/%: $(OBJDIR)/%.o $(OBJ)
+	$(LD) $(ALL_CFLAGS) $^ --output $@ $(LDFLAGS)
+
+$(OBJDIR)/%.o : %.c
+	@mkdir -p $(@D)
+	$(CC) -c $(ALL_CFLAGS) $< -o $@
+
+$(OBJDIR)/%.o : %.cpp
+	@mkdir -p $(@D)
+	$(CXX) -c $(ALL_CPPFLAGS) $< -o $@
+
+clean:
+	$(REMOVEDIR) $(OBJDIR) .dep
+
+
+# Create object files directory
+$(shell mkdir $(OBJDIR) 2>/dev/null)
+
+# Include the dependency files.
+-include $(shell mkdir .dep 2>/dev/null) $(wildcard .dep/*)
+
+.PHONY : all test bench clean